@@ -3,40 +3,191 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
 #include <cstdlib>
 #include <cstdint>
 #include <algorithm>
+#include <limits>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include "bst.h"
 
 struct KeyError { };
 
+/**
+* Augmentation policies for AVLTree. A policy stores some extra Data in every
+* node that is computed from the node and its children, and update() recomputes
+* it for one node once its children are up to date. The tree calls update() on
+* every node whose subtree changes during inserts, removals and rotations, so
+* the data stays correct at O(log n) extra cost per operation.
+*/
+struct NoAugment
+{
+  struct Data {};
+  static const bool enabled = false;
+  static const bool countsSize = false;
+  static const bool aggregates = false;
+  typedef void aggregate_type;
+
+  template<typename NodeT>
+  static void update(NodeT*) {}
+};
+
+/**
+* Keeps the number of nodes in every subtree, which turns AVLTree into an order
+* statistic tree, see select, rank and count_range.
+*/
+struct SubtreeSize
+{
+  struct Data
+  {
+    std::size_t size;
+    Data() : size(1) {}
+  };
+  static const bool enabled = true;
+  static const bool countsSize = true;
+  static const bool aggregates = false;
+  typedef void aggregate_type;
+
+  template<typename NodeT>
+  static std::size_t size(const NodeT* node)
+  {
+    return node == NULL ? 0 : node->getAugment().size;
+  }
+
+  template<typename NodeT>
+  static void update(NodeT* node)
+  {
+    node->getAugment().size = 1 + size(node->getLeft()) + size(node->getRight());
+  }
+};
+
+/**
+* Monoids for the Aggregate policy. A monoid has a value_type, an identity(),
+* an associative combine(a, b) and lift(value), which turns the value of one
+* node into a value_type. Any class with these members can be used.
+*/
+template<typename T>
+struct SumOf
+{
+  typedef T value_type;
+  static T identity() { return T(); }
+  static T combine(const T& a, const T& b) { return a + b; }
+  template<typename V>
+  static T lift(const V& value) { return T(value); }
+};
+
+template<typename T>
+struct MinOf
+{
+  typedef T value_type;
+  static T identity() { return std::numeric_limits<T>::max(); }
+  static T combine(const T& a, const T& b) { return std::min(a, b); }
+  template<typename V>
+  static T lift(const V& value) { return T(value); }
+};
+
+template<typename T>
+struct MaxOf
+{
+  typedef T value_type;
+  static T identity() { return std::numeric_limits<T>::lowest(); }
+  static T combine(const T& a, const T& b) { return std::max(a, b); }
+  template<typename V>
+  static T lift(const V& value) { return T(value); }
+};
+
+/**
+* Keeps the Monoid's combination of all values in every subtree, so AVLTree can
+* answer aggregate(lo, hi) in O(log n). Values are combined in key order, so the
+* monoid does not have to be commutative.
+*/
+template<typename Monoid>
+struct Aggregate
+{
+  typedef Monoid monoid_type;
+  typedef typename Monoid::value_type aggregate_type;
+
+  struct Data
+  {
+    aggregate_type total;
+    Data() : total(Monoid::identity()) {}
+  };
+  static const bool enabled = true;
+  static const bool countsSize = false;
+  static const bool aggregates = true;
+
+  template<typename NodeT>
+  static aggregate_type total(const NodeT* node)
+  {
+    return node == NULL ? Monoid::identity() : node->getAugment().total;
+  }
+
+  template<typename NodeT>
+  static void update(NodeT* node)
+  {
+    node->getAugment().total = Monoid::combine(Monoid::combine(total(node->getLeft()), Monoid::lift(node->getValue())),
+                                               total(node->getRight()));
+  }
+};
+
+/**
+* Value policies for the AVLTree set operations. When a key is in both trees the
+* receiving tree keeps its own node, and the policy is called as policy(own, other)
+* with both values to decide what that node ends up holding. Any callable with
+* that signature works, e.g. a lambda that adds the two values.
+*/
+struct KeepOwnValue
+{
+  template<typename V>
+  void operator()(V& own, V& other) const {}
+};
+
+struct TakeOtherValue
+{
+  template<typename V>
+  void operator()(V& own, V& other) const { own = std::move(other); }
+};
+
 /**
 * A special kind of node for an AVL tree, which adds the balance as a data member, plus
 * other additional helper functions. You do NOT need to implement any functionality or
-* add additional data members or helper functions.
+* add additional data members or helper functions. The Augment policy adds its own
+* per node data, which takes no extra space for NoAugment.
 */
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Augment = NoAugment>
 class AVLNode : public Node<Key, Value>
 {
   public:
     // Constructor/destructor.
-    AVLNode(const Key& key, const Value& value, AVLNode<Key, Value>* parent);
-    virtual ~AVLNode();
+    AVLNode(const Key& key, const Value& value, AVLNode<Key, Value, Augment>* parent);
+    template<typename KeyArg, typename... ValueArgs>
+    AVLNode(AVLNode<Key, Value, Augment>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs);
+    template<typename... Args>
+    AVLNode(AVLNode<Key, Value, Augment>* parent, EmplaceItem, Args&&... args);
+    BST_NODE_VIRTUAL ~AVLNode() BST_NODE_OVERRIDE = default;
 
     // Getter/setter for the node's height.
     int8_t getBalance () const;
     void setBalance (int8_t balance);
     void updateBalance(int8_t diff);
 
+    // Getters for the data of the augmentation policy.
+    const typename Augment::Data& getAugment() const;
+    typename Augment::Data& getAugment();
+
     // Getters for parent, left, and right. These need to be redefined since they
-    // return pointers to AVLNodes - not plain Nodes. See the Node class in bst.h
-    // for more information.
-    virtual AVLNode<Key, Value>* getParent() const override;
-    virtual AVLNode<Key, Value>* getLeft() const override;
-    virtual AVLNode<Key, Value>* getRight() const override;
+    // return pointers to AVLNodes - not plain Nodes. They hide the Node getters
+    // rather than override them, see the Node class in bst.h for more information.
+    BST_NODE_VIRTUAL AVLNode<Key, Value, Augment>* getParent() const BST_NODE_OVERRIDE;
+    BST_NODE_VIRTUAL AVLNode<Key, Value, Augment>* getLeft() const BST_NODE_OVERRIDE;
+    BST_NODE_VIRTUAL AVLNode<Key, Value, Augment>* getRight() const BST_NODE_OVERRIDE;
 
   protected:
     int8_t balance_;    // effectively a signed char
+    typename Augment::Data augment_;
 };
 
 /*
@@ -48,18 +199,28 @@ class AVLNode : public Node<Key, Value>
 /**
 * An explicit constructor to initialize the elements by calling the base class constructor
 */
-template<class Key, class Value>
-AVLNode<Key, Value>::AVLNode(const Key& key, const Value& value, AVLNode<Key, Value> *parent) :
+template<class Key, class Value, class Augment>
+AVLNode<Key, Value, Augment>::AVLNode(const Key& key, const Value& value, AVLNode<Key, Value, Augment> *parent) :
 Node<Key, Value>(key, value, parent), balance_(0)
 {
 
 }
 
 /**
-* A destructor which does nothing.
+* An explicit constructor which builds the item in place, see the matching Node constructor
 */
-template<class Key, class Value>
-AVLNode<Key, Value>::~AVLNode()
+template<class Key, class Value, class Augment>
+template<typename KeyArg, typename... ValueArgs>
+AVLNode<Key, Value, Augment>::AVLNode(AVLNode<Key, Value, Augment>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs) :
+Node<Key, Value>(parent, std::piecewise_construct, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...), balance_(0)
+{
+
+}
+
+template<class Key, class Value, class Augment>
+template<typename... Args>
+AVLNode<Key, Value, Augment>::AVLNode(AVLNode<Key, Value, Augment>* parent, EmplaceItem, Args&&... args) :
+Node<Key, Value>(parent, EmplaceItem(), std::forward<Args>(args)...), balance_(0)
 {
 
 }
@@ -67,8 +228,8 @@ AVLNode<Key, Value>::~AVLNode()
 /**
 * A getter for the balance of a AVLNode.
 */
-template<class Key, class Value>
-int8_t AVLNode<Key, Value>::getBalance() const
+template<class Key, class Value, class Augment>
+int8_t AVLNode<Key, Value, Augment>::getBalance() const
 {
   return balance_;
 }
@@ -76,8 +237,8 @@ int8_t AVLNode<Key, Value>::getBalance() const
 /**
 * A setter for the balance of a AVLNode.
 */
-template<class Key, class Value>
-void AVLNode<Key, Value>::setBalance(int8_t balance)
+template<class Key, class Value, class Augment>
+void AVLNode<Key, Value, Augment>::setBalance(int8_t balance)
 {
   balance_ = balance;
 }
@@ -85,38 +246,56 @@ void AVLNode<Key, Value>::setBalance(int8_t balance)
 /**
 * Adds diff to the balance of a AVLNode.
 */
-template<class Key, class Value>
-void AVLNode<Key, Value>::updateBalance(int8_t diff)
+template<class Key, class Value, class Augment>
+void AVLNode<Key, Value, Augment>::updateBalance(int8_t diff)
 {
   balance_ += diff;
 }
 
 /**
-* An overridden function for getting the parent since a static_cast is necessary to make sure
+* A const getter for the augmentation data of a AVLNode.
+*/
+template<class Key, class Value, class Augment>
+const typename Augment::Data& AVLNode<Key, Value, Augment>::getAugment() const
+{
+  return augment_;
+}
+
+/**
+* A non-const getter for the augmentation data of a AVLNode.
+*/
+template<class Key, class Value, class Augment>
+typename Augment::Data& AVLNode<Key, Value, Augment>::getAugment()
+{
+  return augment_;
+}
+
+/**
+* A redefined function for getting the parent since a static_cast is necessary to make sure
 * that our node is a AVLNode.
 */
-template<class Key, class Value>
-AVLNode<Key, Value> *AVLNode<Key, Value>::getParent() const
+template<class Key, class Value, class Augment>
+AVLNode<Key, Value, Augment> *AVLNode<Key, Value, Augment>::getParent() const
 {
-  return static_cast<AVLNode<Key, Value>*>(this->parent_);
+  return static_cast<AVLNode<Key, Value, Augment>*>(this->parent_);
 }
 
 /**
-* Overridden for the same reasons as above.
+* Redefined for the same reasons as above.
 */
-template<class Key, class Value>
-AVLNode<Key, Value> *AVLNode<Key, Value>::getLeft() const
+template<class Key, class Value, class Augment>
+AVLNode<Key, Value, Augment> *AVLNode<Key, Value, Augment>::getLeft() const
 {
-  return static_cast<AVLNode<Key, Value>*>(this->left_);
+  return static_cast<AVLNode<Key, Value, Augment>*>(this->left_);
 }
 
 /**
-* Overridden for the same reasons as above.
+* Redefined for the same reasons as above.
 */
-template<class Key, class Value>
-AVLNode<Key, Value> *AVLNode<Key, Value>::getRight() const
+template<class Key, class Value, class Augment>
+AVLNode<Key, Value, Augment> *AVLNode<Key, Value, Augment>::getRight() const
 {
-  return static_cast<AVLNode<Key, Value>*>(this->right_);
+  return static_cast<AVLNode<Key, Value, Augment>*>(this->right_);
 }
 
 
@@ -127,35 +306,142 @@ AVLNode<Key, Value> *AVLNode<Key, Value>::getRight() const
 */
 
 
-template <class Key, class Value>
-class AVLTree : public BinarySearchTree<Key, Value>
+/**
+* A self balancing AVL tree. Like BinarySearchTree its nodes come from the Alloc policy.
+* The Augment policy keeps extra data in every node, e.g. AVLTree<Key, Value, SlabArena,
+* SubtreeSize> supports select, rank and count_range in O(log n), and with
+* Aggregate<SumOf<Value> > aggregate(lo, hi) sums the values of a key range in O(log n).
+* The totals only follow value changes made by the tree, so an Aggregate tree hands
+* out its values read only: its iterator is a const_iterator and operator[] returns
+* a const reference. Change a value with insert or insert_or_assign instead.
+*/
+template <class Key, class Value, class Alloc = SlabArena, class Augment = NoAugment>
+class AVLTree : public BinarySearchTree<Key, Value, Alloc>
 {
+  protected:
+    // the base class iterator, which the virtual functions have to keep
+    typedef typename BinarySearchTree<Key, Value, Alloc>::iterator BaseIterator;
+
   public:
+    typedef typename std::conditional<Augment::aggregates,
+                                      typename BinarySearchTree<Key, Value, Alloc>::const_iterator,
+                                      typename BinarySearchTree<Key, Value, Alloc>::iterator>::type iterator;
+    typedef typename BinarySearchTree<Key, Value, Alloc>::const_iterator const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef typename std::conditional<Augment::aggregates, Value const &, Value&>::type mapped_reference;
+
     AVLTree();
+    template<typename InputIt>
+    AVLTree(InputIt first, InputIt last);
     ~AVLTree();
-    virtual void insert (const std::pair<const Key, Value> &new_item); // TODO
+    using BinarySearchTree<Key, Value, Alloc>::insert;
+    virtual void insert (const std::pair<const Key, Value> &new_item) override; // TODO
     virtual void remove(const Key& key);  // TODO
+    virtual void clear();
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last);
+    void insert_parallel(std::vector<std::pair<Key, Value> > items, unsigned threads = 0);
+
+    // Move aware insertion, see BinarySearchTree
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value);
+    virtual BaseIterator insert(BaseIterator hint, const std::pair<const Key, Value>& new_item) override;
+    iterator insert(const_iterator hint, const std::pair<const Key, Value>& new_item);
+
+    // Lookups that return this tree's iterator, see above
+    iterator begin() const;
+    iterator end() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    iterator find(const Key& key) const;
+    void findMany(const std::vector<Key>& keys, std::vector<iterator>& results) const;
+    iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    std::pair<iterator, iterator> equal_range(const Key& key) const;
+    using BinarySearchTree<Key, Value, Alloc>::operator[];
+    mapped_reference operator[](const Key& key);
+
+    // Order statistics, these need the SubtreeSize augmentation
+    iterator select(std::size_t k) const;
+    std::size_t rank(const Key& key) const;
+    std::size_t count_range(const Key& lo, const Key& hi) const;
+
+    // Range aggregate, this needs an Aggregate augmentation
+    typename Augment::aggregate_type aggregate(const Key& lo, const Key& hi) const;
+
+    // Moving whole key ranges between trees in O(log n)
+    void split(const Key& key, AVLTree& right);
+    void join(AVLTree& right);
+
+    // Set operations that move the nodes of other into this tree and leave other empty
+    template<typename Resolve = KeepOwnValue>
+    void set_union(AVLTree& other, Resolve resolve = Resolve());
+    template<typename Resolve = KeepOwnValue>
+    void set_intersection(AVLTree& other, Resolve resolve = Resolve());
+    void set_difference(AVLTree& other);
   
   protected:
+    typedef AVLNode<Key, Value, Augment> NodeType;
 
-    virtual void nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2);
+    virtual void nodeSwap( AVLNode<Key, Value, Augment>* n1, AVLNode<Key, Value, Augment>* n2);
     
+    virtual std::pair<BaseIterator, bool> moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite) override;
+    virtual bool plainNodes() const override;
+
     // Add helper functions here
-    void insertFix(AVLNode<Key, Value>* parent, AVLNode<Key, Value>* child);
-    void removeFix(AVLNode<Key, Value>* node, int diff);
-    void rotateRight(AVLNode<Key, Value>* node);
-    void rotateLeft(AVLNode<Key, Value>* node);
-    bool has2Children(AVLNode<Key, Value>* node);
-    void doClear(AVLNode<Key, Value>* curr);
-    void clear();
-    int getNodeHeight(const AVLNode<Key, Value>* current) const;
-    static AVLNode<Key, Value>* predecessor(AVLNode<Key, Value>* current);
+    void insertRebalance(AVLNode<Key, Value, Augment>* node);
+    void insertFix(AVLNode<Key, Value, Augment>* parent, AVLNode<Key, Value, Augment>* child);
+    void removeFix(AVLNode<Key, Value, Augment>* node, int diff);
+    void rotateRight(AVLNode<Key, Value, Augment>* node);
+    void rotateLeft(AVLNode<Key, Value, Augment>* node);
+    void updatePath(AVLNode<Key, Value, Augment>* node);
+    AVLNode<Key, Value, Augment>* unlinkNode(AVLNode<Key, Value, Augment>* curr);
+
+    // split/join helpers, heights count the nodes on the longest path down
+    static int subtreeHeight(const NodeType* root);
+    static int childHeight(const NodeType* node, int height, bool left);
+    static NodeType* linkNodes(NodeType* left, NodeType* mid, NodeType* right, int leftHeight, int rightHeight, int& height);
+    static NodeType* joinNodes(NodeType* left, int leftHeight, NodeType* mid, NodeType* right, int rightHeight, int& height);
+    static NodeType* joinRight(NodeType* left, int leftHeight, NodeType* mid, NodeType* right, int rightHeight, int& height);
+    static NodeType* joinLeft(NodeType* left, int leftHeight, NodeType* mid, NodeType* right, int rightHeight, int& height);
+    static void splitNodes(NodeType* root, int height, const Key& key,
+                           NodeType*& left, int& leftHeight, NodeType*& right, int& rightHeight,
+                           NodeType** match = NULL);
+    static NodeType* joinPair(NodeType* left, int leftHeight, NodeType* right, int rightHeight, int& height);
+    static NodeType* splitLast(NodeType* root, int height, NodeType*& last, int& restHeight);
+
+    // set operation helpers, a is this tree's side and b the other tree's
+    template<typename Resolve>
+    NodeType* unionNodes(NodeType* a, int aHeight, NodeType* b, int bHeight, Resolve& resolve, int& height);
+    template<typename Resolve>
+    NodeType* intersectNodes(NodeType* a, int aHeight, NodeType* b, int bHeight, Resolve& resolve, int& height);
+    NodeType* differenceNodes(NodeType* a, int aHeight, NodeType* b, int bHeight, int& height);
+    void dropNodes(NodeType* root);
+    void takeNodes(AVLTree& other, NodeType* root);
+    template<typename Func>
+    static void runParallel(std::size_t parts, Func func);
+    static void sortParallel(std::vector<std::pair<Key, Value> >& items, std::size_t parts);
+
+    // below this many items per thread insert_parallel uses fewer threads
+    static const std::size_t PARALLEL_MIN_ITEMS = 16384;
+    bool has2Children(AVLNode<Key, Value, Augment>* node);
+    template<typename InputIt>
+    AVLNode<Key, Value, Augment>* buildBalanced(InputIt& it, std::size_t count, int& height);
+    static AVLNode<Key, Value, Augment>* predecessor(AVLNode<Key, Value, Augment>* current);
 
     //override function
-    AVLNode<Key, Value>* internalFind(const Key& k) const;
+    AVLNode<Key, Value, Augment>* internalFind(const Key& k) const;
 
     //root node for AVL
-    AVLNode<Key, Value>* rootAVL;
+    AVLNode<Key, Value, Augment>* rootAVL;
   
 };
 
@@ -165,30 +451,129 @@ class AVLTree : public BinarySearchTree<Key, Value>
 */
 
 //constructor
-template<class Key, class Value>
-AVLTree<Key, Value>::AVLTree() : BinarySearchTree<Key, Value>(), rootAVL(NULL) {}
+template<class Key, class Value, class Alloc, class Augment>
+AVLTree<Key, Value, Alloc, Augment>::AVLTree() : BinarySearchTree<Key, Value, Alloc>(), rootAVL(NULL) {}
+
+/**
+* Builds a perfectly balanced tree from a range of key/value pairs sorted by
+* strictly increasing key, in linear time. See assign().
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename InputIt>
+AVLTree<Key, Value, Alloc, Augment>::AVLTree(InputIt first, InputIt last) : BinarySearchTree<Key, Value, Alloc>(), rootAVL(NULL)
+{
+  assign(first, last);
+}
 
 //destructor
-template<typename Key, typename Value>
-AVLTree<Key, Value>::~AVLTree()
+template<typename Key, typename Value, typename Alloc, typename Augment>
+AVLTree<Key, Value, Alloc, Augment>::~AVLTree()
 {
   // TODO
   clear();
 }
 
-template<typename Key, typename Value>
-void AVLTree<Key, Value>::clear()
+template<typename Key, typename Value, typename Alloc, typename Augment>
+void AVLTree<Key, Value, Alloc, Augment>::clear()
 {
   //TODO
-  BinarySearchTree<Key, Value>::doClear(this->rootAVL);
+  this->clearNodes(this->rootAVL);
   rootAVL = NULL;
   this->root_ = NULL;
 }
 
-template<class Key, class Value>
-AVLNode<Key, Value>* AVLTree<Key, Value>::internalFind(const Key& k) const
+/**
+* Replaces the contents of the tree with the pairs in [first, last), which must
+* be sorted by strictly increasing key. The tree is built bottom up in O(n)
+* without any rotations, and every balance is set directly from the subtree
+* heights. The range is read twice, so it needs forward iterators. Throws
+* std::invalid_argument, leaving the tree untouched, if the keys are not sorted.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename InputIt>
+void AVLTree<Key, Value, Alloc, Augment>::assign(InputIt first, InputIt last)
+{
+  //check the order before anything is thrown away
+  std::size_t count = 0;
+  for(InputIt prev = first, curr = first; curr != last; prev = curr, ++curr)
+  {
+    if(count > 0 && !(prev->first < curr->first))
+    {
+      throw std::invalid_argument("AVLTree::assign needs keys in strictly increasing order");
+    }
+    ++count;
+  }
+
+  clear();
+
+  int height = 0;
+  InputIt it = first;
+  rootAVL = buildBalanced(it, count, height);
+  this->root_ = rootAVL;
+}
+
+/**
+* Builds a balanced subtree from the next count items of it and returns its root.
+* Items are consumed in order: left subtree, then the root, then the right subtree.
+* The left side gets the smaller half, so no balance ever goes outside -1..1.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename InputIt>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::buildBalanced(InputIt& it, std::size_t count, int& height)
+{
+  if(count == 0)
+  {
+    height = 0;
+    return NULL;
+  }
+
+  std::size_t leftCount = (count - 1) / 2;
+  int leftHeight = 0;
+  int rightHeight = 0;
+
+  AVLNode<Key, Value, Augment>* left = buildBalanced(it, leftCount, leftHeight);
+  AVLNode<Key, Value, Augment>* node = NULL;
+  AVLNode<Key, Value, Augment>* right = NULL;
+
+  //free what was already built if a copy or allocation throws
+  try
+  {
+    //(*it) rather than it-> so a move_iterator moves the pair in
+    node = this->template createNode<AVLNode<Key, Value, Augment> >(NULL, std::piecewise_construct, (*it).first, (*it).second);
+    ++it;
+    right = buildBalanced(it, count - 1 - leftCount, rightHeight);
+  }
+  catch(...)
+  {
+    this->doClear(left);
+    if(node != NULL)
+    {
+      this->destroyNode(node);
+    }
+    throw;
+  }
+
+  node->setLeft(left);
+  node->setRight(right);
+  if(left != NULL)
+  {
+    left->setParent(node);
+  }
+  if(right != NULL)
+  {
+    right->setParent(node);
+  }
+
+  node->setBalance(rightHeight - leftHeight);
+  Augment::update(node);
+  height = 1 + std::max(leftHeight, rightHeight);
+  return node;
+}
+
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::internalFind(const Key& k) const
 {
-  AVLNode<Key, Value>* temp = rootAVL;
+  AVLNode<Key, Value, Augment>* temp = rootAVL;
 
   //logic of where to insert
   while(temp != NULL)
@@ -215,224 +600,276 @@ AVLNode<Key, Value>* AVLTree<Key, Value>::internalFind(const Key& k) const
   return NULL;
 }
 
-template<class Key, class Value>
-AVLNode<Key, Value>* AVLTree<Key, Value>::predecessor(AVLNode<Key, Value>* current)
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::predecessor(AVLNode<Key, Value, Augment>* current)
 {
-  // TODO
-  if(current == NULL)
+  return static_cast<AVLNode<Key, Value, Augment>*>(BinarySearchTree<Key, Value, Alloc>::predecessor(current));
+}
+
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::insert (const std::pair<const Key, Value> &new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  insert_or_assign(std::move(item.first), std::move(item.second));
+}
+
+template<class Key, class Value, class Alloc, class Augment>
+template<typename... Args>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::emplace(Args&&... args)
+{
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceItemNode<AVLNode<Key, Value, Augment> >(std::forward<Args>(args)...);
+  if(result.second)
   {
-    return NULL;
+    insertRebalance(result.first);
   }
-  
-  AVLNode<Key, Value>* suc = NULL;
-  if(current->getLeft() != NULL)
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc, class Augment>
+template<typename... Args>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::try_emplace(const Key& key, Args&&... args)
+{
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNode<AVLNode<Key, Value, Augment> >(key, std::forward<Args>(args)...);
+  if(result.second)
   {
-    suc = current->getLeft();
-    while(suc->getRight() != NULL)
-    {
-      suc = suc->getRight();
-    }
-    return suc;
+    insertRebalance(result.first);
   }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
 
-  else
+template<class Key, class Value, class Alloc, class Augment>
+template<typename... Args>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::try_emplace(Key&& key, Args&&... args)
+{
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNode<AVLNode<Key, Value, Augment> >(std::move(key), std::forward<Args>(args)...);
+  if(result.second)
   {
-    if(current->getParent() == NULL)
-    {
-      return NULL;;
-    }
-
-    suc = current->getParent();
-
-    if((suc != NULL) && (suc->getRight() != NULL))
-    { 
-      AVLNode<Key, Value>* temp = suc->getParent()->getRight();
-
-      if((suc->getRight() != NULL)&&(temp->getKey() == current->getKey()))
-      {
-        return suc;
-      }
-
-      else
-      {
-        return NULL;
-      }
-    }
-
-    else
-    {
-      suc = suc->getParent();
-      while(suc->getRight() != current)
-      {
-        suc = suc->getParent();
-        if(suc->getParent() == NULL)
-        {
-          return NULL;
-        }
-      }
-      return suc;
-    }
+    insertRebalance(result.first);
   }
-
-  return NULL;
+  return std::make_pair(this->makeIterator(result.first), result.second);
 }
 
-template<class Key, class Value>
-void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
+template<class Key, class Value, class Alloc, class Augment>
+template<typename V>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::insert_or_assign(const Key& key, V&& value)
 {
-  // TODO
-  if(this->root_ == NULL)
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNode<AVLNode<Key, Value, Augment> >(key, std::forward<V>(value));
+  if(result.second)
   {
-    //allocate new memory for inserted pair
-    AVLNode<Key, Value>* newNode = new AVLNode<Key, Value>(new_item.first, new_item.second, NULL);
-    rootAVL = newNode;
-    rootAVL->setLeft(NULL);
-    rootAVL->setRight(NULL);
-    rootAVL->setBalance(0); //idk bout this
-
-    this->root_ = rootAVL;
-    return;
+    insertRebalance(result.first);
   }
-
-  AVLNode<Key, Value>* temp = rootAVL;
-
-  if((new_item.first == temp->getKey())) //&& (temp->getRight() == NULL) && (temp->getLeft() == NULL)
+  else
   {
-    temp->setValue(new_item.second);
-    return;
+    result.first->getValue() = std::forward<V>(value);
+    updatePath(result.first);
   }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
 
-  //allocate new memory for inserted pair
-  AVLNode<Key, Value>* newNode = new AVLNode<Key, Value>(new_item.first, new_item.second, temp);
-  newNode->setBalance(0);
-
-  if((temp->getLeft() == NULL) || (temp->getRight() == NULL))
+template<class Key, class Value, class Alloc, class Augment>
+template<typename V>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::insert_or_assign(Key&& key, V&& value)
+{
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNode<AVLNode<Key, Value, Augment> >(std::move(key), std::forward<V>(value));
+  if(result.second)
   {
-
-    if((new_item.first > temp->getKey()) && (temp->getRight() == NULL))
-    {
-    
-      //set child
-      temp->setRight(newNode);
-
-      //set parent
-      newNode->setParent(temp);
-
-      //update new node balance
-      newNode->setBalance(0);
-
-      //update parent node balance
-      temp->updateBalance(1);
-
-      //check balance of parent
-      if(temp->getBalance() != 0)
-      {
-        insertFix(temp, newNode);
-      }
-
-      return;
-    }
-
-    else if((new_item.first < temp->getKey()) && (temp->getLeft() == NULL))
-    {
-      //set child
-      temp->setLeft(newNode);
-
-      //set parent
-      newNode->setParent(temp);
-
-      //update parent node balance
-      temp->updateBalance(-1);
-
-      //check balance of parent
-      if(temp->getBalance() != 0)
-      {
-        insertFix(temp, newNode);
-      }
-
-      return;
-    }
+    insertRebalance(result.first);
+  }
+  else
+  {
+    result.first->getValue() = std::forward<V>(value);
+    updatePath(result.first);
   }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
 
-  //logic of where to insert
-  while(temp != NULL)
+/**
+* Hinted insert, see BinarySearchTree. The new leaf is rebalanced as usual,
+* which is amortized O(1) for a run of inserts.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::BaseIterator
+AVLTree<Key, Value, Alloc, Augment>::insert(BaseIterator hint, const std::pair<const Key, Value>& new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNodeHint<AVLNode<Key, Value, Augment> >(this->hintNode(hint), std::move(item.first), std::move(item.second));
+  if(result.second)
   {
-    if((new_item.first == temp->getKey()))
-    {
-      temp->setValue(new_item.second);
-      return;
-    }
+    insertRebalance(result.first);
+  }
+  else
+  {
+    result.first->setValue(std::move(item.second));
+    updatePath(result.first);
+  }
+  return this->makeIterator(result.first);
+}
 
-    //less than, and must traverse
-    else if((new_item.first < temp->getKey()) && (temp->getLeft() != NULL))
-    {
-      temp = temp->getLeft();
-    }
+/**
+* The same with a const_iterator hint, the only kind an Aggregate tree hands out.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::insert(const_iterator hint, const std::pair<const Key, Value>& new_item)
+{
+  return insert(this->makeIterator(this->hintNode(hint)), new_item);
+}
 
-    //greater than, must traverse
-    else if((new_item.first > temp->getKey()) && (temp->getRight() != NULL))
-    {
-      temp = temp->getRight();
-    }
+template<class Key, class Value, class Alloc, class Augment>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::BaseIterator, bool>
+AVLTree<Key, Value, Alloc, Augment>::moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite)
+{
+  std::pair<AVLNode<Key, Value, Augment>*, bool> result =
+    this->template emplaceNode<AVLNode<Key, Value, Augment> >(std::move(keyValuePair.first), std::move(keyValuePair.second));
+  if(result.second)
+  {
+    insertRebalance(result.first);
+  }
+  else if(overwrite)
+  {
+    result.first->setValue(std::move(keyValuePair.second));
+    updatePath(result.first);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
 
-    //less than, able to allocate
-    else if((new_item.first < temp->getKey()) && (temp->getLeft() == NULL))
-    {
-      
-      //set child
-      temp->setLeft(newNode);
+template<class Key, class Value, class Alloc, class Augment>
+bool AVLTree<Key, Value, Alloc, Augment>::plainNodes() const
+{
+  return false;
+}
 
-      //update parent node balance
-      temp->updateBalance(-1);
+/**
+* The lookups of BinarySearchTree, returning this tree's iterator.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::begin() const
+{
+  return BinarySearchTree<Key, Value, Alloc>::begin();
+}
 
-      //set parent
-      newNode->setParent(temp);
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::end() const
+{
+  return BinarySearchTree<Key, Value, Alloc>::end();
+}
 
-      //check balance of parent
-      if(temp->getBalance() != 0)
-      {
-        insertFix(temp, newNode);
-      }
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::reverse_iterator
+AVLTree<Key, Value, Alloc, Augment>::rbegin() const
+{
+  return reverse_iterator(end());
+}
 
-      break;
-    }
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::reverse_iterator
+AVLTree<Key, Value, Alloc, Augment>::rend() const
+{
+  return reverse_iterator(begin());
+}
 
-    //greater than, able to allocate
-    else
-    {
-      //set child
-      temp->setRight(newNode);
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::find(const Key& key) const
+{
+  return BinarySearchTree<Key, Value, Alloc>::find(key);
+}
 
-      //update parent node balance
-      temp->updateBalance(1);
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::findMany(const std::vector<Key>& keys, std::vector<iterator>& results) const
+{
+  BinarySearchTree<Key, Value, Alloc>::findMany(keys, results);
+}
 
-      //set parent
-      newNode->setParent(temp);
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::lower_bound(const Key& key) const
+{
+  return BinarySearchTree<Key, Value, Alloc>::lower_bound(key);
+}
 
-      //check balance of parent
-      if(temp->getBalance() != 0)
-      {
-        insertFix(temp, newNode);
-      }
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::upper_bound(const Key& key) const
+{
+  return BinarySearchTree<Key, Value, Alloc>::upper_bound(key);
+}
 
-      break;
-    }
-  }
+template<class Key, class Value, class Alloc, class Augment>
+std::pair<typename AVLTree<Key, Value, Alloc, Augment>::iterator,
+          typename AVLTree<Key, Value, Alloc, Augment>::iterator>
+AVLTree<Key, Value, Alloc, Augment>::equal_range(const Key& key) const
+{
+  return BinarySearchTree<Key, Value, Alloc>::equal_range(key);
+}
 
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::mapped_reference
+AVLTree<Key, Value, Alloc, Augment>::operator[](const Key& key)
+{
+  return BinarySearchTree<Key, Value, Alloc>::operator[](key);
 }
 
-//my helper function
-template<class Key, class Value>
-void AVLTree<Key, Value>::insertFix(AVLNode<Key, Value>* parent, AVLNode<Key, Value>* child)
+/**
+* Updates balances after node was linked in as a new leaf by emplaceNode.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::insertRebalance(AVLNode<Key, Value, Augment>* node)
 {
-  if(parent == NULL || child == NULL)
+  AVLNode<Key, Value, Augment>* parent = node->getParent();
+
+  //every ancestor gained a node, rotations below keep this up to date
+  updatePath(node);
+
+  //first node, emplaceNode only set the base class root
+  if(parent == NULL)
   {
+    rootAVL = node;
     return;
   }
 
-  //initialize grandParent node
-  AVLNode<Key, Value>* grandParent = parent->getParent();
-
+  //update parent node balance
+  if(parent->getLeft() == node)
+  {
+    parent->updateBalance(-1);
+  }
+  else
+  {
+    parent->updateBalance(1);
+  }
+
+  //check balance of parent
+  if(parent->getBalance() != 0)
+  {
+    insertFix(parent, node);
+  }
+}
+
+//my helper function
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::insertFix(AVLNode<Key, Value, Augment>* parent, AVLNode<Key, Value, Augment>* child)
+{
+  if(parent == NULL || child == NULL)
+  {
+    return;
+  }
+
+  //initialize grandParent node
+  AVLNode<Key, Value, Augment>* grandParent = parent->getParent();
+
   if(grandParent == NULL)
   {
     return;
@@ -560,11 +997,11 @@ void AVLTree<Key, Value>::insertFix(AVLNode<Key, Value>* parent, AVLNode<Key, Va
 }
 
 //my helper function
-template<class Key, class Value>
-void AVLTree<Key, Value>::rotateRight(AVLNode<Key, Value>* node)
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::rotateRight(AVLNode<Key, Value, Augment>* node)
 {
-	AVLNode<Key, Value>* left = node->getLeft();
-	AVLNode<Key, Value>* parent = node->getParent();
+	AVLNode<Key, Value, Augment>* left = node->getLeft();
+	AVLNode<Key, Value, Augment>* parent = node->getParent();
   
 	//node is not a root
 	if(parent  != NULL)
@@ -601,16 +1038,20 @@ void AVLTree<Key, Value>::rotateRight(AVLNode<Key, Value>* node)
 
   left->setRight(node);
   node->setParent(left);
+
+  //node is now below left
+  Augment::update(node);
+  Augment::update(left);
   return;
 }
 
 //my helper function
-template<class Key, class Value>
-void AVLTree<Key, Value>::rotateLeft(AVLNode<Key, Value>* node)
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::rotateLeft(AVLNode<Key, Value, Augment>* node)
 {
   //necessary pointer
-  AVLNode<Key, Value>* parent = node->getParent();
-  AVLNode<Key, Value>* right = node->getRight();
+  AVLNode<Key, Value, Augment>* parent = node->getParent();
+  AVLNode<Key, Value, Augment>* right = node->getRight();
 
   //node is not a root
 	if(parent  != NULL)
@@ -647,6 +1088,10 @@ void AVLTree<Key, Value>::rotateLeft(AVLNode<Key, Value>* node)
 
   right->setLeft(node);
   node->setParent(right);
+
+  //node is now below right
+  Augment::update(node);
+  Augment::update(right);
   return;
 
 }
@@ -656,316 +1101,98 @@ void AVLTree<Key, Value>::rotateLeft(AVLNode<Key, Value>* node)
  * Recall: The writeup specifies that if a node has 2 children you
  * should swap with the predecessor and then remove.
  */
-template<class Key, class Value>
-void AVLTree<Key, Value>::remove(const Key& key)
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::remove(const Key& key)
 {
-  //tree is empty
-  if(rootAVL == NULL)
-  {
-    return;
-  }
+  //target node
+  AVLNode<Key, Value, Augment>* curr = internalFind(key);
 
-  //target node and temp root
-  AVLNode<Key, Value>* curr = internalFind(key);
-  AVLNode<Key, Value>* temp = rootAVL;
-  bool didSwitch = false;
-  bool isRoot = false;
-  int diff = 0;
-  
   //target not in tree
   if(curr == NULL)
   {
     return;
   }
 
-  //2 child case
-  if((curr->getLeft() != NULL) && (curr->getRight() != NULL))
+  this->destroyNode(unlinkNode(curr));
+}
+
+/**
+* Takes curr out of the tree and rebalances, without destroying it. Returns curr,
+* which is the node that leaves the tree even if it had two children, since nodes
+* are swapped with their predecessor rather than their items.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::unlinkNode(AVLNode<Key, Value, Augment>* curr)
+{
+  //the largest node is found again lazily
+  if(curr == this->rightmost_)
   {
-    temp = predecessor(curr);
-    nodeSwap(temp, curr);
-    didSwitch = true;
+    this->rightmost_ = NULL;
   }
 
-  if(didSwitch == false)
+  //2 child case, after the swap curr has at most a left child
+  if((curr->getLeft() != NULL) && (curr->getRight() != NULL))
   {
-    //logic to determine if we are deleting a root
-    if(rootAVL == curr)
-    {
-      isRoot = true;
-    }
-
-    //pointers to assist with removal
-    AVLNode<Key, Value>* left = curr->getLeft();
-    AVLNode<Key, Value>* right = curr->getRight();
-    AVLNode<Key, Value>* parent = curr->getParent();
-    
-
-    //logic for getting difference
-    if(parent != NULL)
-    {
-      //right subtree will increase in height
-      if(curr == parent->getLeft())
-      {
-        diff = 1;
-      }
-
-      //left subtree will increase in height
-      else
-      {
-        diff = -1;
-      }
-    }
-
-    //0 child and deleting a root
-    if((isRoot) && (right == NULL) && (left == NULL))
-    {
-      curr->setBalance(0);
-      delete curr;
-      rootAVL = NULL;
-      this->root_ = NULL;
-    }
-
-    //1 child case
-    else if(((left != NULL) && (right == NULL)) || ((left == NULL) && (right != NULL)))
-    {
-      //target node is the root
-      if(isRoot == true)
-      {
-        //rootAVL->setBalance(0);
-
-        //target node has left child
-        if(left != NULL)
-        {
-          this->root_ = left;
-          rootAVL = left;
-          left->setParent(NULL);
-          left->setBalance(curr->getBalance());
-        }
-        //target node has right child
-        else
-        {
-          this->root_ = right;
-          rootAVL = right;
-          right->setParent(NULL);
-          right->setBalance(curr->getBalance());
-        }
-      }
-
-      //target node is not the root
-      else
-      {
-        //target has a left child
-        if(left != NULL)
-        {
-          left->setParent(parent);
-          
-          //target is a left child
-          if(parent->getLeft() == curr)
-          {
-            parent->updateBalance(-1);
-            parent->setLeft(left);
-          }
-          //target is a right child
-          else
-          {
-            parent->updateBalance(1);
-            parent->setRight(left);
-          }   
-        } 
-
-        //target has a right child
-        else
-        {
-          right->setParent(parent);
-
-          //target is a left child
-          if(parent->getLeft() == curr)
-          {
-            parent->updateBalance(-1);
-            parent->setLeft(right);  
-          }
-
-          //target is a right child
-          else
-          {
-            parent->updateBalance(1);
-            parent->setRight(right);
-          }
-        }
-      }
+    nodeSwap(predecessor(curr), curr);
+    rootAVL = static_cast<AVLNode<Key, Value, Augment>*>(this->root_);
+  }
 
-      delete curr;
-    }
+  //splice curr out by linking its only child (if any) to its parent
+  AVLNode<Key, Value, Augment>* parent = curr->getParent();
+  AVLNode<Key, Value, Augment>* child = curr->getLeft();
+  if(child == NULL)
+  {
+    child = curr->getRight();
+  }
 
-    //0 child case
-    else
-    {
-      //target node is a left child
-      if(parent->getLeft() == curr)
-      {
-        parent->setLeft(NULL);
-      }
+  if(child != NULL)
+  {
+    child->setParent(parent);
+  }
 
-      //target node is a right child
-      else
-      {
-        parent->setRight(NULL);
-      }
+  int diff = 0;
 
-      delete curr;
-    }
+  //target node is the root
+  if(parent == NULL)
+  {
+    rootAVL = child;
+    this->root_ = child;
+  }
 
-    //patch up tree
-    removeFix(parent, diff);
+  //target is a left child, so the right subtree is now relatively taller
+  else if(parent->getLeft() == curr)
+  {
+    parent->setLeft(child);
+    diff = 1;
   }
 
-  //did do switch
+  //target is a right child, so the left subtree is now relatively taller
   else
   {
-    if(rootAVL == temp)
-    {
-      isRoot = true;
-    }
-    //logic to determine if we are deleting a root
-    if(rootAVL == curr)
-    {
-      rootAVL = temp;
-      this->root_ = temp;
-    }
-
-    //pointers to assist with removal
-    AVLNode<Key, Value>* left = curr->getLeft();
-    AVLNode<Key, Value>* right = curr->getRight();
-    AVLNode<Key, Value>* parent = curr->getParent();
-    
-
-    //logic for getting difference
-    if(parent != NULL)
-    {
-      //right subtree will increase in height
-      if(curr == parent->getLeft())
-      {
-        diff = 1;
-      }
-
-      //left subtree will increase in height
-      else
-      {
-        diff = -1;
-      }
-    }
-
-    //0 child and deleting a root
-    if((isRoot) && (right == NULL) && (left == NULL))
-    {
-      curr->setBalance(0);
-      delete curr;
-      rootAVL = NULL;
-      this->root_ = NULL;
-    }
-
-    //1 child case
-    else if(((left != NULL) && (right == NULL)) || ((left == NULL) && (right != NULL)))
-    {
-      //target node is the root
-      if(isRoot == true)
-      {
-        //target node has left child
-        if(left != NULL)
-        {
-          this->root_ = left;
-          rootAVL = left;
-          left->setParent(NULL);
-          left->setBalance(curr->getBalance());
-        }
-        //target node has right child
-        else
-        {
-          this->root_ = right;
-          rootAVL = right;
-          right->setParent(NULL);
-          right->setBalance(curr->getBalance());
-        }
-      }
-
-      //target node is not the root
-      else
-      {
-        //target has a left child
-        if(left != NULL)
-        {
-          left->setParent(parent);
-          
-          //target is a left child
-          if(curr->getLeft() == left)
-          {
-            parent->updateBalance(-1);
-            parent->setLeft(left);
-          }
-          //target is a right child
-          else
-          {
-            parent->updateBalance(1);
-            parent->setRight(left);
-          }   
-        } 
-
-        //target has a right child
-        else
-        {
-          right->setParent(parent);
-
-          //target is a left child
-          if(curr->getLeft() == right)
-          {
-            curr->updateBalance(-1);
-            curr->setLeft(right);  
-          }
-
-          //target is a right child
-          else
-          {
-            curr->updateBalance(1);
-            curr->setRight(right);
-          }
-        }
-      }
-
-      delete curr;
-    }
-
-    //0 child case
-    else
-    {
-      //target node is a left child
-      if(parent->getLeft() == curr)
-      {
-        parent->setLeft(NULL);
-      }
-
-      //target node is a right child
-      else
-      {
-        parent->setRight(NULL);
-      }
+    parent->setRight(child);
+    diff = -1;
+  }
 
-      delete curr;
-    }
+  curr->setParent(NULL);
+  curr->setLeft(NULL);
+  curr->setRight(NULL);
+  curr->setBalance(0);
 
-    //patch up tree
-    removeFix(parent, diff);
-  }
+  //patch up tree
+  updatePath(parent);
+  removeFix(parent, diff);
+  return curr;
 }
 
-template<class Key, class Value>
-void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::removeFix(AVLNode<Key, Value, Augment>* node, int diff)
 {
   if(node == NULL)
   {
     return;
   }
 
-  AVLNode<Key, Value>* parent = node->getParent();
+  AVLNode<Key, Value, Augment>* parent = node->getParent();
   int ndiff = -1;
 
 
@@ -981,12 +1208,8 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
   {
     if(node->getBalance() + diff == -2)
     {
-      //initialize tallChild to be left child, and change if it isnt true
-      AVLNode<Key, Value>* tallChild = node->getLeft();
-      if(getNodeHeight(node->getLeft()) < getNodeHeight(node->getRight()))
-      {
-        tallChild = node->getRight();
-      }
+      //the right side shrank, so the left child is the tall one
+      AVLNode<Key, Value, Augment>* tallChild = node->getLeft();
 
       //zig-zig 1
       if(tallChild->getBalance() == -1)
@@ -1009,7 +1232,7 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
       else
       {
         //initialize grandParent
-        AVLNode<Key, Value>* grandParent = tallChild->getRight();
+        AVLNode<Key, Value, Augment>* grandParent = tallChild->getRight();
         rotateLeft(tallChild);
         rotateRight(node);
         
@@ -1056,12 +1279,8 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
   {
     if(node->getBalance() + diff == 2)
     {
-      //initialize tallChild to be left child, and change if it isnt true
-      AVLNode<Key, Value>* tallChild = node->getLeft();
-      if(getNodeHeight(node->getLeft()) < getNodeHeight(node->getRight()))
-      {
-        tallChild = node->getRight();
-      }
+      //the left side shrank, so the right child is the tall one
+      AVLNode<Key, Value, Augment>* tallChild = node->getRight();
 
       //zig-zig 1
       if(tallChild->getBalance() == 1)
@@ -1084,7 +1303,7 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
       else
       {
         //initialize grandParent
-        AVLNode<Key, Value>* grandParent = tallChild->getRight();
+        AVLNode<Key, Value, Augment>* grandParent = tallChild->getLeft();
         rotateRight(tallChild);
         rotateLeft(node);
 
@@ -1129,32 +1348,948 @@ void AVLTree<Key, Value>::removeFix(AVLNode<Key, Value>* node, int diff)
 
 }
 
-//my helper function
-template<typename Key, typename Value>
-int AVLTree<Key, Value>::getNodeHeight(const AVLNode<Key, Value>* current) const
+/**
+* Recomputes the augmentation data of node and all of its ancestors, bottom up.
+* Does nothing without an augmentation policy.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::updatePath(AVLNode<Key, Value, Augment>* node)
+{
+  if(!Augment::enabled)
+  {
+    return;
+  }
+
+  while(node != NULL)
+  {
+    Augment::update(node);
+    node = node->getParent();
+  }
+}
+
+/**
+* Returns an iterator to the k-th smallest key (counting from 0), or end()
+* if the tree has k or fewer keys. O(log n) using the subtree sizes.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+typename AVLTree<Key, Value, Alloc, Augment>::iterator
+AVLTree<Key, Value, Alloc, Augment>::select(std::size_t k) const
 {
-    // Base case
-    if(current == NULL)
+  static_assert(Augment::countsSize, "select needs an AVLTree with the SubtreeSize augmentation");
+
+  AVLNode<Key, Value, Augment>* node = rootAVL;
+  while(node != NULL)
+  {
+    std::size_t leftSize = Augment::size(node->getLeft());
+
+    //answer is in the left subtree
+    if(k < leftSize)
     {
-        return -1;
+      node = node->getLeft();
     }
-       
-    // Initialize distance as -1
-    int dist = -1;
-  
-    if((dist = getNodeHeight(current->getLeft() ) >= 0) || (dist = getNodeHeight(current->getRight() ) >= 0))
+
+    //exactly leftSize keys are smaller than node
+    else if(k == leftSize)
     {
-      // Return depth of the node
-      return dist + 1;
+      return this->makeIterator(node);
     }
-  
-    return dist;
 
+    //skip the left subtree and node itself
+    else
+    {
+      k -= leftSize + 1;
+      node = node->getRight();
+    }
+  }
+
+  return this->end();
+}
+
+/**
+* Returns the number of keys in the tree that are smaller than key, which
+* does not need to be in the tree itself. O(log n) using the subtree sizes.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+std::size_t AVLTree<Key, Value, Alloc, Augment>::rank(const Key& key) const
+{
+  static_assert(Augment::countsSize, "rank needs an AVLTree with the SubtreeSize augmentation");
+
+  std::size_t count = 0;
+  AVLNode<Key, Value, Augment>* node = rootAVL;
+  while(node != NULL)
+  {
+    //node and its whole left subtree are smaller
+    if(node->getKey() < key)
+    {
+      count += Augment::size(node->getLeft()) + 1;
+      node = node->getRight();
+    }
+    else
+    {
+      node = node->getLeft();
+    }
+  }
+
+  return count;
+}
+
+/**
+* Returns the number of keys k with lo <= k < hi, in O(log n).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+std::size_t AVLTree<Key, Value, Alloc, Augment>::count_range(const Key& lo, const Key& hi) const
+{
+  if(!(lo < hi))
+  {
+    return 0;
+  }
+  return rank(hi) - rank(lo);
+}
+
+/**
+* Returns the Monoid's combination of the values of all keys k with lo <= k < hi,
+* in key order, or the identity if there are none. The walk splits where the paths
+* to lo and hi part and then adds whole subtrees on the way down each path, so it
+* is O(log n).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+typename Augment::aggregate_type AVLTree<Key, Value, Alloc, Augment>::aggregate(const Key& lo, const Key& hi) const
+{
+  static_assert(Augment::aggregates, "aggregate needs an AVLTree with an Aggregate augmentation");
+  typedef typename Augment::aggregate_type T;
+  typedef typename Augment::monoid_type Monoid;
+
+  //highest node inside the range, every other node in range is below it
+  AVLNode<Key, Value, Augment>* split = rootAVL;
+  while(split != NULL)
+  {
+    if(split->getKey() < lo)
+    {
+      split = split->getRight();
+    }
+    else if(!(split->getKey() < hi))
+    {
+      split = split->getLeft();
+    }
+    else
+    {
+      break;
+    }
+  }
+
+  if(split == NULL)
+  {
+    return Monoid::identity();
+  }
+
+  //keys at least lo on the left, found from the largest down so they are prepended
+  T leftPart = Monoid::identity();
+  AVLNode<Key, Value, Augment>* node = split->getLeft();
+  while(node != NULL)
+  {
+    if(node->getKey() < lo)
+    {
+      node = node->getRight();
+    }
+    else
+    {
+      T here = Monoid::combine(Monoid::lift(node->getValue()), Augment::total(node->getRight()));
+      leftPart = Monoid::combine(here, leftPart);
+      node = node->getLeft();
+    }
+  }
+
+  //keys below hi on the right, found from the smallest up so they are appended
+  T rightPart = Monoid::identity();
+  node = split->getRight();
+  while(node != NULL)
+  {
+    if(node->getKey() < hi)
+    {
+      T here = Monoid::combine(Augment::total(node->getLeft()), Monoid::lift(node->getValue()));
+      rightPart = Monoid::combine(rightPart, here);
+      node = node->getRight();
+    }
+    else
+    {
+      node = node->getLeft();
+    }
+  }
+
+  return Monoid::combine(Monoid::combine(leftPart, Monoid::lift(split->getValue())), rightPart);
+}
+
+/**
+* Moves every item with a key of at least key into right, which must be empty,
+* and keeps the smaller ones. No item is copied or reallocated: the tree is cut
+* along the path to key and the pieces are joined back together, which is
+* O(log n) in total. Afterwards both arenas are in one group (see SlabArena),
+* so their nodes can keep moving between them, and each tree can still be used
+* from its own thread. Throws std::invalid_argument if right is not empty.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::split(const Key& key, AVLTree& right)
+{
+  if(&right == this || !right.empty())
+  {
+    throw std::invalid_argument("AVLTree::split needs a different, empty tree for the right part");
+  }
+
+  right.alloc_.share(this->alloc_);
+
+  NodeType* left = NULL;
+  NodeType* rightRoot = NULL;
+  int leftHeight = 0;
+  int rightHeight = 0;
+  splitNodes(rootAVL, subtreeHeight(rootAVL), key, left, leftHeight, rightRoot, rightHeight);
+
+  rootAVL = left;
+  this->root_ = left;
+  this->rightmost_ = NULL;
+  right.rootAVL = rightRoot;
+  right.root_ = rightRoot;
+  right.rightmost_ = NULL;
+}
+
+/**
+* Moves every item of right, whose keys must all be larger than the keys in this
+* tree, to the end of this tree and leaves right empty. The largest node of this
+* tree is taken out and used to link the two trees at the height of the shorter
+* one, which is O(log n). Throws std::invalid_argument if the keys overlap.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::join(AVLTree& right)
+{
+  if(&right == this || right.rootAVL == NULL)
+  {
+    return;
+  }
+
+  if(rootAVL != NULL && !(this->getLargestNode()->getKey() < right.getSmallestNode()->getKey()))
+  {
+    throw std::invalid_argument("AVLTree::join needs every key of the right tree to be larger");
+  }
+
+  //the nodes of right now belong to this tree
+  this->alloc_.absorb(right.alloc_);
+
+  NodeType* root = right.rootAVL;
+  if(rootAVL != NULL)
+  {
+    NodeType* mid = unlinkNode(static_cast<NodeType*>(this->getLargestNode()));
+    int height = 0;
+    root = joinNodes(rootAVL, subtreeHeight(rootAVL), mid, right.rootAVL, subtreeHeight(right.rootAVL), height);
+  }
+
+  rootAVL = root;
+  this->root_ = root;
+  this->rightmost_ = right.rightmost_;
+  right.rootAVL = NULL;
+  right.root_ = NULL;
+  right.rightmost_ = NULL;
+
+  //right is empty now, so let it start a group of its own again
+  right.alloc_.release();
+}
+
+/**
+* Returns the height of a subtree in O(log n) by always following the taller child.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+int AVLTree<Key, Value, Alloc, Augment>::subtreeHeight(const NodeType* root)
+{
+  int height = 0;
+  while(root != NULL)
+  {
+    ++height;
+    root = (root->getBalance() > 0 ? root->getRight() : root->getLeft());
+  }
+  return height;
+}
+
+/**
+* Returns the height of the left or right child of node, given node's height.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+int AVLTree<Key, Value, Alloc, Augment>::childHeight(const NodeType* node, int height, bool left)
+{
+  int balance = node->getBalance();
+  if(left)
+  {
+    return height - 1 - (balance > 0 ? balance : 0);
+  }
+  return height - 1 + (balance < 0 ? balance : 0);
+}
+
+/**
+* Makes left and right the children of mid, whose subtrees must be at most one apart
+* in height, and returns mid with its balance and augmentation set.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::linkNodes(NodeType* left, NodeType* mid, NodeType* right,
+    int leftHeight, int rightHeight, int& height)
+{
+  mid->setParent(NULL);
+  mid->setLeft(left);
+  mid->setRight(right);
+  if(left != NULL)
+  {
+    left->setParent(mid);
+  }
+  if(right != NULL)
+  {
+    right->setParent(mid);
+  }
+
+  mid->setBalance(rightHeight - leftHeight);
+  Augment::update(mid);
+  height = 1 + std::max(leftHeight, rightHeight);
+  return mid;
+}
+
+/**
+* Joins two trees and a middle node whose key lies between them, into one AVL tree.
+* The shorter tree is hung off the side of the taller one at its own height, and the
+* join costs O(difference in height).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::joinNodes(NodeType* left, int leftHeight, NodeType* mid,
+    NodeType* right, int rightHeight, int& height)
+{
+  if(leftHeight > rightHeight + 1)
+  {
+    return joinRight(left, leftHeight, mid, right, rightHeight, height);
+  }
+  if(rightHeight > leftHeight + 1)
+  {
+    return joinLeft(left, leftHeight, mid, right, rightHeight, height);
+  }
+  return linkNodes(left, mid, right, leftHeight, rightHeight, height);
+}
+
+/**
+* joinNodes when left is the taller tree: walk down its right spine to a subtree
+* that is at most one taller than right, link there, and rotate on the way back up.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::joinRight(NodeType* left, int leftHeight, NodeType* mid,
+    NodeType* right, int rightHeight, int& height)
+{
+  NodeType* outer = left->getLeft();
+  NodeType* inner = left->getRight();
+  int outerHeight = childHeight(left, leftHeight, true);
+  int innerHeight = childHeight(left, leftHeight, false);
+
+  NodeType* joined;
+  int joinedHeight;
+  if(innerHeight <= rightHeight + 1)
+  {
+    joined = linkNodes(inner, mid, right, innerHeight, rightHeight, joinedHeight);
+    if(joinedHeight <= outerHeight + 1)
+    {
+      return linkNodes(outer, left, joined, outerHeight, joinedHeight, height);
+    }
+
+    //joined leans left and is two taller than outer, double rotation brings inner up
+    NodeType* innerLeft = inner->getLeft();
+    NodeType* innerRight = inner->getRight();
+    int innerLeftHeight = childHeight(inner, innerHeight, true);
+    int innerRightHeight = childHeight(inner, innerHeight, false);
+    int lowHeight;
+    int highHeight;
+    NodeType* low = linkNodes(outer, left, innerLeft, outerHeight, innerLeftHeight, lowHeight);
+    NodeType* high = linkNodes(innerRight, mid, right, innerRightHeight, rightHeight, highHeight);
+    return linkNodes(low, inner, high, lowHeight, highHeight, height);
+  }
+
+  joined = joinRight(inner, innerHeight, mid, right, rightHeight, joinedHeight);
+  if(joinedHeight <= outerHeight + 1)
+  {
+    return linkNodes(outer, left, joined, outerHeight, joinedHeight, height);
+  }
+
+  //joined grew too tall, a single left rotation fixes it
+  NodeType* joinedLeft = joined->getLeft();
+  NodeType* joinedRight = joined->getRight();
+  int joinedLeftHeight = childHeight(joined, joinedHeight, true);
+  int joinedRightHeight = childHeight(joined, joinedHeight, false);
+  int lowHeight;
+  NodeType* low = linkNodes(outer, left, joinedLeft, outerHeight, joinedLeftHeight, lowHeight);
+  return linkNodes(low, joined, joinedRight, lowHeight, joinedRightHeight, height);
+}
+
+/**
+* The mirror image of joinRight, for when right is the taller tree.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::joinLeft(NodeType* left, int leftHeight, NodeType* mid,
+    NodeType* right, int rightHeight, int& height)
+{
+  NodeType* outer = right->getRight();
+  NodeType* inner = right->getLeft();
+  int outerHeight = childHeight(right, rightHeight, false);
+  int innerHeight = childHeight(right, rightHeight, true);
+
+  NodeType* joined;
+  int joinedHeight;
+  if(innerHeight <= leftHeight + 1)
+  {
+    joined = linkNodes(left, mid, inner, leftHeight, innerHeight, joinedHeight);
+    if(joinedHeight <= outerHeight + 1)
+    {
+      return linkNodes(joined, right, outer, joinedHeight, outerHeight, height);
+    }
+
+    //joined leans right and is two taller than outer, double rotation brings inner up
+    NodeType* innerLeft = inner->getLeft();
+    NodeType* innerRight = inner->getRight();
+    int innerLeftHeight = childHeight(inner, innerHeight, true);
+    int innerRightHeight = childHeight(inner, innerHeight, false);
+    int lowHeight;
+    int highHeight;
+    NodeType* low = linkNodes(left, mid, innerLeft, leftHeight, innerLeftHeight, lowHeight);
+    NodeType* high = linkNodes(innerRight, right, outer, innerRightHeight, outerHeight, highHeight);
+    return linkNodes(low, inner, high, lowHeight, highHeight, height);
+  }
+
+  joined = joinLeft(left, leftHeight, mid, inner, innerHeight, joinedHeight);
+  if(joinedHeight <= outerHeight + 1)
+  {
+    return linkNodes(joined, right, outer, joinedHeight, outerHeight, height);
+  }
+
+  //joined grew too tall, a single right rotation fixes it
+  NodeType* joinedLeft = joined->getLeft();
+  NodeType* joinedRight = joined->getRight();
+  int joinedLeftHeight = childHeight(joined, joinedHeight, true);
+  int joinedRightHeight = childHeight(joined, joinedHeight, false);
+  int highHeight;
+  NodeType* high = linkNodes(joinedRight, right, outer, joinedRightHeight, outerHeight, highHeight);
+  return linkNodes(joinedLeft, joined, high, joinedLeftHeight, highHeight, height);
+}
+
+/**
+* Splits the subtree at root into the nodes with keys below key (left) and the rest
+* (right). Every node on the path to key is joined into one side or the other with
+* the subtree hanging off it, and the height differences of those joins add up to
+* O(log n). If match is given, a node holding key is not put into right but
+* detached and returned through *match, which the caller must set to NULL first.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::splitNodes(NodeType* root, int height, const Key& key,
+    NodeType*& left, int& leftHeight, NodeType*& right, int& rightHeight, NodeType** match)
+{
+  if(root == NULL)
+  {
+    left = NULL;
+    right = NULL;
+    leftHeight = 0;
+    rightHeight = 0;
+    return;
+  }
+
+  NodeType* rootLeft = root->getLeft();
+  NodeType* rootRight = root->getRight();
+  int rootLeftHeight = childHeight(root, height, true);
+  int rootRightHeight = childHeight(root, height, false);
+
+  //root and its left subtree go left, the cut is somewhere on the right
+  if(root->getKey() < key)
+  {
+    NodeType* lower;
+    int lowerHeight;
+    splitNodes(rootRight, rootRightHeight, key, lower, lowerHeight, right, rightHeight, match);
+    left = joinNodes(rootLeft, rootLeftHeight, root, lower, lowerHeight, leftHeight);
+  }
+
+  //root holds key itself, hand it out and keep its subtrees as they are
+  else if(match != NULL && !(key < root->getKey()))
+  {
+    root->setLeft(NULL);
+    root->setRight(NULL);
+    root->setParent(NULL);
+    *match = root;
+    left = rootLeft;
+    leftHeight = rootLeftHeight;
+    right = rootRight;
+    rightHeight = rootRightHeight;
+  }
+
+  //root and its right subtree go right, the cut is somewhere on the left
+  else
+  {
+    NodeType* upper;
+    int upperHeight;
+    splitNodes(rootLeft, rootLeftHeight, key, left, leftHeight, upper, upperHeight, match);
+    right = joinNodes(upper, upperHeight, root, rootRight, rootRightHeight, rightHeight);
+  }
+
+  if(left != NULL)
+  {
+    left->setParent(NULL);
+  }
+  if(right != NULL)
+  {
+    right->setParent(NULL);
+  }
+}
+
+/**
+* Joins two trees whose keys are all smaller on the left, with no middle node, by
+* taking the largest node of left out and joining on it. O(log n).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::joinPair(NodeType* left, int leftHeight,
+    NodeType* right, int rightHeight, int& height)
+{
+  if(left == NULL)
+  {
+    height = rightHeight;
+    return right;
+  }
+
+  NodeType* last;
+  int restHeight;
+  NodeType* rest = splitLast(left, leftHeight, last, restHeight);
+  return joinNodes(rest, restHeight, last, right, rightHeight, height);
+}
+
+/**
+* Takes the largest node out of the subtree at root, returns it through last and
+* returns the rest of the subtree, rebalanced by joins on the way back up.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::splitLast(NodeType* root, int height,
+    NodeType*& last, int& restHeight)
+{
+  NodeType* rootLeft = root->getLeft();
+  int rootLeftHeight = childHeight(root, height, true);
+  if(root->getRight() == NULL)
+  {
+    if(rootLeft != NULL)
+    {
+      rootLeft->setParent(NULL);
+    }
+    root->setLeft(NULL);
+    root->setParent(NULL);
+    last = root;
+    restHeight = rootLeftHeight;
+    return rootLeft;
+  }
+
+  int rightRestHeight;
+  NodeType* rightRest = splitLast(root->getRight(), childHeight(root, height, false), last, rightRestHeight);
+  NodeType* rest = joinNodes(rootLeft, rootLeftHeight, root, rightRest, rightRestHeight, restHeight);
+  rest->setParent(NULL);
+  return rest;
+}
+
+/**
+* Moves every item of other into this tree and leaves other empty. For keys in both
+* trees this tree keeps its node and resolve(own, other) decides its value, see
+* KeepOwnValue and TakeOtherValue; the other node is destroyed. No item is copied.
+* The tree is rebuilt by splitting other at this tree's keys and joining the pieces,
+* which costs O(m log(n/m + 1)) for trees of m <= n items instead of the
+* O(m log(n + m)) of inserting them one by one.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename Resolve>
+void AVLTree<Key, Value, Alloc, Augment>::set_union(AVLTree& other, Resolve resolve)
+{
+  if(&other == this)
+  {
+    return;
+  }
+
+  this->alloc_.absorb(other.alloc_);
+  int height;
+  NodeType* root = unionNodes(rootAVL, subtreeHeight(rootAVL), other.rootAVL, subtreeHeight(other.rootAVL), resolve, height);
+  takeNodes(other, root);
+}
+
+/**
+* Keeps only the items whose keys are also in other, and leaves other empty. Like
+* set_union this tree keeps its own nodes and resolve(own, other) decides their
+* values. Every dropped node is destroyed, the restructuring itself costs
+* O(m log(n/m + 1)).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename Resolve>
+void AVLTree<Key, Value, Alloc, Augment>::set_intersection(AVLTree& other, Resolve resolve)
+{
+  if(&other == this)
+  {
+    return;
+  }
+
+  this->alloc_.absorb(other.alloc_);
+  int height;
+  NodeType* root = intersectNodes(rootAVL, subtreeHeight(rootAVL), other.rootAVL, subtreeHeight(other.rootAVL), resolve, height);
+  takeNodes(other, root);
+}
+
+/**
+* Removes every item whose key is in other, and leaves other empty. Every dropped
+* node is destroyed, the restructuring itself costs O(m log(n/m + 1)).
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::set_difference(AVLTree& other)
+{
+  if(&other == this)
+  {
+    clear();
+    return;
+  }
+
+  this->alloc_.absorb(other.alloc_);
+  int height;
+  NodeType* root = differenceNodes(rootAVL, subtreeHeight(rootAVL), other.rootAVL, subtreeHeight(other.rootAVL), height);
+  takeNodes(other, root);
+}
+
+/**
+* The union of the subtrees a and b: b is split at a's root key, the halves are
+* united with a's subtrees and joined back on a's root.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename Resolve>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::unionNodes(NodeType* a, int aHeight,
+    NodeType* b, int bHeight, Resolve& resolve, int& height)
+{
+  if(b == NULL)
+  {
+    height = aHeight;
+    return a;
+  }
+  if(a == NULL)
+  {
+    height = bHeight;
+    return b;
+  }
+
+  NodeType* match = NULL;
+  NodeType* bLeft;
+  NodeType* bRight;
+  int bLeftHeight;
+  int bRightHeight;
+  splitNodes(b, bHeight, a->getKey(), bLeft, bLeftHeight, bRight, bRightHeight, &match);
+  if(match != NULL)
+  {
+    resolve(a->getValue(), match->getValue());
+    this->destroyNode(match);
+  }
+
+  int leftHeight;
+  int rightHeight;
+  NodeType* left = unionNodes(a->getLeft(), childHeight(a, aHeight, true), bLeft, bLeftHeight, resolve, leftHeight);
+  NodeType* right = unionNodes(a->getRight(), childHeight(a, aHeight, false), bRight, bRightHeight, resolve, rightHeight);
+  return joinNodes(left, leftHeight, a, right, rightHeight, height);
+}
+
+/**
+* The intersection of the subtrees a and b, split and joined like unionNodes. a's
+* root stays only if b had its key.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename Resolve>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::intersectNodes(NodeType* a, int aHeight,
+    NodeType* b, int bHeight, Resolve& resolve, int& height)
+{
+  if(a == NULL || b == NULL)
+  {
+    dropNodes(a);
+    dropNodes(b);
+    height = 0;
+    return NULL;
+  }
+
+  NodeType* match = NULL;
+  NodeType* bLeft;
+  NodeType* bRight;
+  int bLeftHeight;
+  int bRightHeight;
+  splitNodes(b, bHeight, a->getKey(), bLeft, bLeftHeight, bRight, bRightHeight, &match);
+
+  int leftHeight;
+  int rightHeight;
+  NodeType* left = intersectNodes(a->getLeft(), childHeight(a, aHeight, true), bLeft, bLeftHeight, resolve, leftHeight);
+  NodeType* right = intersectNodes(a->getRight(), childHeight(a, aHeight, false), bRight, bRightHeight, resolve, rightHeight);
+  if(match == NULL)
+  {
+    a->setLeft(NULL);
+    a->setRight(NULL);
+    this->destroyNode(a);
+    return joinPair(left, leftHeight, right, rightHeight, height);
+  }
+
+  resolve(a->getValue(), match->getValue());
+  this->destroyNode(match);
+  return joinNodes(left, leftHeight, a, right, rightHeight, height);
+}
+
+/**
+* The subtree a without the keys of the subtree b, split and joined like unionNodes.
+* a's root stays only if b did not have its key.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+AVLNode<Key, Value, Augment>* AVLTree<Key, Value, Alloc, Augment>::differenceNodes(NodeType* a, int aHeight,
+    NodeType* b, int bHeight, int& height)
+{
+  if(a == NULL || b == NULL)
+  {
+    dropNodes(b);
+    height = aHeight;
+    return a;
+  }
+
+  NodeType* match = NULL;
+  NodeType* bLeft;
+  NodeType* bRight;
+  int bLeftHeight;
+  int bRightHeight;
+  splitNodes(b, bHeight, a->getKey(), bLeft, bLeftHeight, bRight, bRightHeight, &match);
+
+  int leftHeight;
+  int rightHeight;
+  NodeType* left = differenceNodes(a->getLeft(), childHeight(a, aHeight, true), bLeft, bLeftHeight, leftHeight);
+  NodeType* right = differenceNodes(a->getRight(), childHeight(a, aHeight, false), bRight, bRightHeight, rightHeight);
+  if(match == NULL)
+  {
+    return joinNodes(left, leftHeight, a, right, rightHeight, height);
+  }
+
+  a->setLeft(NULL);
+  a->setRight(NULL);
+  this->destroyNode(a);
+  this->destroyNode(match);
+  return joinPair(left, leftHeight, right, rightHeight, height);
+}
+
+//my helper function, destroys a whole detached subtree
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::dropNodes(NodeType* root)
+{
+  if(root != NULL)
+  {
+    root->setParent(NULL);
+    this->doClear(root);
+  }
+}
+
+//my helper function, makes root the new root and empties other after a set operation
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::takeNodes(AVLTree& other, NodeType* root)
+{
+  if(root != NULL)
+  {
+    root->setParent(NULL);
+  }
+
+  rootAVL = root;
+  this->root_ = root;
+  this->rightmost_ = NULL;
+  other.rootAVL = NULL;
+  other.root_ = NULL;
+  other.rightmost_ = NULL;
+
+  //other is empty now, so let it start a group of its own again
+  other.alloc_.release();
+}
+
+/**
+* Inserts a large batch of items using several threads, with the same result as
+* inserting them one by one: items overwrite the values of keys already in the tree,
+* and if a key appears more than once in the batch the last item wins.
+* The batch is sorted in parallel and cut into one key range per thread. Each thread
+* builds a balanced tree from its range in an arena of its own, with no rotations,
+* and merges it with the part of this tree holding the same key range (see
+* set_union). The parts are joined back together at the end, and the per thread
+* arenas are absorbed into this tree's arena.
+* threads = 0 uses one thread per core, and small batches use fewer threads.
+* If building a part throws, the tree is left untouched.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::insert_parallel(std::vector<std::pair<Key, Value> > items, unsigned threads)
+{
+  if(items.empty())
+  {
+    return;
+  }
+
+  std::size_t parts = (threads == 0 ? std::thread::hardware_concurrency() : threads);
+  parts = std::min(parts, items.size() / PARALLEL_MIN_ITEMS);
+  if(parts == 0)
+  {
+    parts = 1;
+  }
+
+  sortParallel(items, parts);
+
+  //keep only the last item of every key, the stable sort kept them in batch order
+  std::size_t kept = 0;
+  for(std::size_t i = 0; i < items.size(); ++i)
+  {
+    if(kept > 0 && !(items[kept - 1].first < items[i].first))
+    {
+      items[kept - 1] = std::move(items[i]);
+    }
+    else
+    {
+      if(kept != i)
+      {
+        items[kept] = std::move(items[i]);
+      }
+      ++kept;
+    }
+  }
+  items.erase(items.begin() + kept, items.end());
+  parts = std::min(parts, items.size());
+
+  //part j gets the sorted items [begins[j], begins[j + 1])
+  std::vector<std::size_t> begins(parts + 1);
+  for(std::size_t j = 0; j <= parts; ++j)
+  {
+    begins[j] = j * items.size() / parts;
+  }
+
+  //build every part in its own tree, so every thread has its own arena
+  std::vector<AVLTree> built(parts);
+  runParallel(parts, [&](std::size_t j)
+  {
+    typedef std::move_iterator<typename std::vector<std::pair<Key, Value> >::iterator> MoveIt;
+    MoveIt it(items.begin() + begins[j]);
+    int height;
+    built[j].rootAVL = built[j].buildBalanced(it, begins[j + 1] - begins[j], height);
+    built[j].root_ = built[j].rootAVL;
+  });
+
+  //cut this tree at the first key of every part, cuts allocate nothing
+  std::vector<NodeType*> roots(parts);
+  std::vector<int> heights(parts);
+  NodeType* rest = rootAVL;
+  int restHeight = subtreeHeight(rootAVL);
+  for(std::size_t j = parts - 1; j > 0; --j)
+  {
+    NodeType* left;
+    int leftHeight;
+    splitNodes(rest, restHeight, items[begins[j]].first, left, leftHeight, roots[j], heights[j]);
+    rest = left;
+    restHeight = leftHeight;
+  }
+  roots[0] = rest;
+  heights[0] = restHeight;
+
+  //merge every part with its piece of this tree, duplicate nodes go back to the part's arena
+  runParallel(parts, [&](std::size_t j)
+  {
+    TakeOtherValue takeOther;
+    NodeType* part = built[j].rootAVL;
+    roots[j] = built[j].unionNodes(roots[j], heights[j], part, subtreeHeight(part), takeOther, heights[j]);
+    built[j].rootAVL = NULL;
+    built[j].root_ = NULL;
+  });
+
+  NodeType* root = roots[0];
+  int height = heights[0];
+  for(std::size_t j = 1; j < parts; ++j)
+  {
+    root = joinPair(root, height, roots[j], heights[j], height);
+  }
+  for(std::size_t j = 0; j < parts; ++j)
+  {
+    this->alloc_.absorb(built[j].alloc_);
+  }
+
+  if(root != NULL)
+  {
+    root->setParent(NULL);
+  }
+  rootAVL = root;
+  this->root_ = root;
+  this->rightmost_ = NULL;
+}
+
+/**
+* Calls func(j) for every j in [0, parts), each on its own std::thread except for
+* part 0, which runs on the calling thread. If a thread cannot be started its part
+* runs on the calling thread as well. The first exception thrown by any part is
+* rethrown once all of them are done.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+template<typename Func>
+void AVLTree<Key, Value, Alloc, Augment>::runParallel(std::size_t parts, Func func)
+{
+  std::vector<std::exception_ptr> errors(parts);
+  auto runPart = [&](std::size_t j)
+  {
+    try
+    {
+      func(j);
+    }
+    catch(...)
+    {
+      errors[j] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(std::size_t j = 1; j < parts; ++j)
+  {
+    try
+    {
+      workers.push_back(std::thread(runPart, j));
+    }
+    catch(const std::system_error&)
+    {
+      runPart(j);
+    }
+  }
+  runPart(0);
+
+  for(std::size_t i = 0; i < workers.size(); ++i)
+  {
+    workers[i].join();
+  }
+  for(std::size_t j = 0; j < parts; ++j)
+  {
+    if(errors[j])
+    {
+      std::rethrow_exception(errors[j]);
+    }
+  }
+}
+
+/**
+* Stable sorts items by key: every thread sorts one slice, and neighbouring slices
+* are merged pairwise in parallel until one is left.
+*/
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::sortParallel(std::vector<std::pair<Key, Value> >& items, std::size_t parts)
+{
+  auto byKey = [](const std::pair<Key, Value>& a, const std::pair<Key, Value>& b) { return a.first < b.first; };
+  auto slice = [&](std::size_t j) { return items.begin() + j * items.size() / parts; };
+
+  runParallel(parts, [&](std::size_t j)
+  {
+    std::stable_sort(slice(j), slice(j + 1), byKey);
+  });
+
+  for(std::size_t width = 1; width < parts; width *= 2)
+  {
+    std::size_t merges = (parts + 2 * width - 1) / (2 * width);
+    runParallel(merges, [&](std::size_t m)
+    {
+      std::size_t first = 2 * width * m;
+      std::size_t middle = std::min(first + width, parts);
+      std::size_t last = std::min(first + 2 * width, parts);
+      std::inplace_merge(slice(first), slice(middle), slice(last), byKey);
+    });
+  }
 }
 
 //my helper function
-template<class Key, class Value>
-bool AVLTree<Key, Value>::has2Children(AVLNode<Key, Value>* node)
+template<class Key, class Value, class Alloc, class Augment>
+bool AVLTree<Key, Value, Alloc, Augment>::has2Children(AVLNode<Key, Value, Augment>* node)
 {
   if((node->getLeft() != NULL) && (node->getRight() != NULL))
   {
@@ -1165,13 +2300,16 @@ bool AVLTree<Key, Value>::has2Children(AVLNode<Key, Value>* node)
 }
 
 
-template<class Key, class Value>
-void AVLTree<Key, Value>::nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2)
+template<class Key, class Value, class Alloc, class Augment>
+void AVLTree<Key, Value, Alloc, Augment>::nodeSwap( AVLNode<Key, Value, Augment>* n1, AVLNode<Key, Value, Augment>* n2)
 {
-  BinarySearchTree<Key, Value>::nodeSwap(n1, n2);
+  BinarySearchTree<Key, Value, Alloc>::nodeSwap(n1, n2);
   int8_t tempB = n1->getBalance();
   n1->setBalance(n2->getBalance());
   n2->setBalance(tempB);
+
+  //the augmentation data belongs to the position as well
+  std::swap(n1->getAugment(), n2->getAugment());
 }
 
 
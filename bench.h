@@ -0,0 +1,95 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+/**
+* Small helpers shared by the *-bench programs. Every benchmark prints
+* CSV rows to stdout so results can be diffed between builds.
+*/
+
+/**
+* A wall clock stopwatch that starts when it is constructed.
+*/
+class BenchTimer
+{
+  public:
+    BenchTimer() : start_(std::chrono::steady_clock::now()) {}
+
+    // Seconds since construction or the last restart().
+    double seconds() const
+    {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    void restart()
+    {
+      start_ = std::chrono::steady_clock::now();
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+* Returns the keys 0..n-1 in a random order.
+*/
+inline std::vector<int> shuffledKeys(int n, unsigned seed)
+{
+  std::vector<int> keys(n);
+  for(int i = 0; i < n; ++i)
+  {
+    keys[i] = i;
+  }
+  std::mt19937 rng(seed);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  return keys;
+}
+
+/**
+* Returns count keys drawn from a Zipf like distribution with exponent s
+* (0 < s, s != 1), so a few hot keys make up most of the draws. Ranks are
+* sampled by inverting the continuous approximation of the Zipf CDF, which
+* needs no table, and rank r becomes the key scatter[r], e.g. from shuffledKeys,
+* so the hot keys are not all next to each other in the tree. Key streams that
+* should agree on which keys are hot (inserts, finds and removes of one run)
+* have to share scatter and only differ in seed.
+*/
+inline std::vector<int> zipfKeys(const std::vector<int>& scatter, int count, double s, unsigned seed)
+{
+  int n = scatter.size();
+  std::vector<int> keys(count);
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  //H(x) = (x^(1-s) - 1) / (1-s) is the integral of x^-s from 1 to x
+  double t = 1.0 - s;
+  double total = (std::pow(n + 1.0, t) - 1.0) / t;
+  for(int i = 0; i < count; ++i)
+  {
+    double x = std::pow(1.0 + uniform(rng) * total * t, 1.0 / t);
+    int rank = static_cast<int>(x) - 1;
+    if(rank < 0) rank = 0;
+    if(rank >= n) rank = n - 1;
+    keys[i] = scatter[rank];
+  }
+  return keys;
+}
+
+/**
+* Keeps the optimizer from throwing away a scalar result that is never used.
+*/
+template<typename T>
+inline void benchKeep(const T& value)
+{
+  static volatile T sink;
+  sink = value;
+  (void)sink;
+}
+
+#endif
@@ -0,0 +1,443 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <algorithm>
+#include "bst.h"
+#include "avlbst.h"
+#include "rbbst.h"
+#include "splaybst.h"
+#include "btree.h"
+#include "bench.h"
+
+using namespace std;
+
+// Throughput of the basic tree operations, for BinarySearchTree, AVLTree,
+// RedBlackTree, SplayTree, BTree and std::map as a baseline. Every operation is
+// run n times with keys that come from one of four patterns:
+//   sequential  0, 1, 2, ... in order
+//   random      a random permutation of 0..n-1
+//   zipf        skewed draws (s = 0.99) where a few hot keys dominate, the
+//               inserts, finds and removes share one set of hot keys
+//   hot         all of 0..n-1 inserted in random order, then finds and
+//               removes drawn with s = 1.1, so every find hits and at n = 1e6
+//               about 80% of them go to 1% of the keys
+// Output is one CSV row per (tree, pattern, op, n), see main for the columns.
+// find_many does the find workload in batches through the trees' findMany.
+// for_each is a full in order scan through the trees' stack based for_each.
+// freeze and find_frozen snapshot the binary trees into a FrozenIndex and run
+// the find workload on that.
+// range_scan copies the whole key range out in chunks, through rangeScan for
+// the binary trees and a lower_bound plus iterator loop for BTree and std::map.
+// insert_hint_end and insert_hint_last (sequential pattern only) append the
+// keys through the hinted insert, with end() or the iterator the previous
+// insert returned as the hint. Both should cost the same at every n.
+// mixed is a delete heavy mix on a fresh tree: every step removes a key and
+// looks one up, and every other step puts an earlier removed key back, so the
+// tree shrinks to about half its size. ops counts all three kinds.
+// The unbalanced tree turns into a list on sequential keys, so those runs
+// stop at SEQUENTIAL_BST_MAX keys instead of taking hours.
+
+static const int SEQUENTIAL_BST_MAX = 10000;
+static const double ZIPF_S = 0.99;
+static const double HOT_ZIPF_S = 1.1;
+
+// std::map spells insert_or_assign and remove differently than the trees
+template<typename Tree>
+void put(Tree& tree, int key)
+{
+    tree.insert(std::make_pair(key, key));
+}
+
+void put(map<int, int>& tree, int key)
+{
+    tree[key] = key;
+}
+
+template<typename Tree>
+void erase(Tree& tree, int key)
+{
+    tree.remove(key);
+}
+
+void erase(map<int, int>& tree, int key)
+{
+    tree.erase(key);
+}
+
+// Copies every pair into a small buffer, chunk by chunk, and returns how many
+// there were. The trees use rangeScan, std::map a plain iterator loop.
+static const int SCAN_CHUNK = 256;
+
+template<typename Tree>
+int scanAll(const Tree& tree, int lo, int hi)
+{
+    typename Tree::ScanCursor cursor;
+    pair<int, int> buffer[SCAN_CHUNK];
+    long long sum = 0;
+    int total = 0;
+    size_t got;
+    while((got = tree.rangeScan(lo, hi, buffer, SCAN_CHUNK, cursor)) > 0) {
+        for(size_t i = 0; i < got; ++i) {
+            sum += buffer[i].second;
+        }
+        total += got;
+    }
+    benchKeep(sum);
+    return total;
+}
+
+template<typename Map>
+int scanWithIterators(const Map& tree, int lo, int hi)
+{
+    pair<int, int> buffer[SCAN_CHUNK];
+    long long sum = 0;
+    int total = 0;
+    typename Map::const_iterator it = tree.lower_bound(lo);
+    while(it != tree.end() && it->first < hi) {
+        int got = 0;
+        for(; got < SCAN_CHUNK && it != tree.end() && it->first < hi; ++it) {
+            buffer[got++] = *it;
+        }
+        for(int i = 0; i < got; ++i) {
+            sum += buffer[i].second;
+        }
+        total += got;
+    }
+    benchKeep(sum);
+    return total;
+}
+
+int scanAll(const map<int, int>& tree, int lo, int hi)
+{
+    return scanWithIterators(tree, lo, hi);
+}
+
+template<int Fanout>
+int scanAll(const BTree<int, int, Fanout>& tree, int lo, int hi)
+{
+    return scanWithIterators(tree, lo, hi);
+}
+
+// Looks up keys[first, last) as one batch and returns how many were found.
+// The binary trees use findMany, BTree and std::map have no batch lookup and
+// run find in a loop. So does SplayTree, whose lookups have to splay: without
+// that a path left deep by earlier accesses would be walked on every lookup.
+static const int FIND_BATCH = 256;
+
+template<typename Tree>
+int findBatch(const Tree& tree, const vector<int>& keys, int first, int last)
+{
+    vector<int> batch(keys.begin() + first, keys.begin() + last);
+    vector<typename Tree::iterator> results;
+    tree.findMany(batch, results);
+    int found = 0;
+    for(size_t i = 0; i < results.size(); ++i) {
+        if(results[i] != tree.end()) {
+            ++found;
+        }
+    }
+    return found;
+}
+
+template<typename Map>
+int findEach(Map& tree, const vector<int>& keys, int first, int last)
+{
+    int found = 0;
+    for(int i = first; i < last; ++i) {
+        if(tree.find(keys[i]) != tree.end()) {
+            ++found;
+        }
+    }
+    return found;
+}
+
+int findBatch(const map<int, int>& tree, const vector<int>& keys, int first, int last)
+{
+    return findEach(tree, keys, first, last);
+}
+
+template<int Fanout>
+int findBatch(const BTree<int, int, Fanout>& tree, const vector<int>& keys, int first, int last)
+{
+    return findEach(tree, keys, first, last);
+}
+
+int findBatch(SplayTree<int, int>& tree, const vector<int>& keys, int first, int last)
+{
+    return findEach(tree, keys, first, last);
+}
+
+// Appends keys in ascending order through the hinted insert, with end() as the
+// hint or the iterator the previous insert returned. BTree has no hinted insert
+// and returns false.
+template<typename Tree>
+bool appendHinted(Tree& tree, const vector<int>& keys, bool hintLast)
+{
+    typename Tree::iterator last = tree.end();
+    for(size_t i = 0; i < keys.size(); ++i) {
+        last = tree.insert(hintLast ? last : tree.end(), make_pair(keys[i], keys[i]));
+    }
+    return true;
+}
+
+template<int Fanout>
+bool appendHinted(BTree<int, int, Fanout>& tree, const vector<int>& keys, bool hintLast)
+{
+    return false;
+}
+
+// Adds up the values of a full scan
+struct SumItems
+{
+    long long sum;
+    int count;
+    SumItems() : sum(0), count(0) {}
+    void operator()(const pair<const int, int>& item)
+    {
+        sum += item.second;
+        ++count;
+    }
+};
+
+// The trees have their own for_each, std::map uses std::for_each
+template<typename Tree>
+void forEach(const Tree& tree, SumItems& adder)
+{
+    tree.for_each([&adder](const pair<const int, int>& item) { adder(item); });
+}
+
+void forEach(const map<int, int>& tree, SumItems& adder)
+{
+    for_each(tree.begin(), tree.end(), [&adder](const pair<const int, int>& item) { adder(item); });
+}
+
+
+static void report(const char* tree, const char* pattern, const char* op, int n, int ops, double secs)
+{
+    cout << tree << "," << pattern << "," << op << "," << n << "," << ops << ","
+         << secs << "," << secs * 1e9 / ops << endl;
+}
+
+// The binary trees can be frozen into a FrozenIndex, the others have nothing to freeze
+template<typename Tree>
+void runFrozen(const char* name, const char* pattern, const Tree& tree, const vector<int>& finds)
+{
+    int n = finds.size();
+    BenchTimer timer;
+    FrozenIndex<int, int> index = tree.freeze();
+    report(name, pattern, "freeze", n, index.size(), timer.seconds());
+
+    long long found = 0;
+    timer.restart();
+    for(int i = 0; i < n; ++i) {
+        if(index.find(finds[i]) != index.end()) {
+            ++found;
+        }
+    }
+    report(name, pattern, "find_frozen", n, n, timer.seconds());
+    benchKeep(found);
+}
+
+void runFrozen(const char* name, const char* pattern, const map<int, int>& tree, const vector<int>& finds)
+{
+}
+
+template<int Fanout>
+void runFrozen(const char* name, const char* pattern, const BTree<int, int, Fanout>& tree, const vector<int>& finds)
+{
+}
+
+// Keys for the inserts, lookups and removals of one run
+struct Workload
+{
+    vector<int> inserts;
+    vector<int> finds;
+    vector<int> removes;
+};
+
+static Workload makeWorkload(const string& pattern, int n)
+{
+    Workload w;
+    if(pattern == "sequential") {
+        w.inserts.resize(n);
+        for(int i = 0; i < n; ++i) {
+            w.inserts[i] = i;
+        }
+        w.finds = w.inserts;
+        w.removes = w.inserts;
+    }
+    else if(pattern == "random") {
+        w.inserts = shuffledKeys(n, 104);
+        w.finds = shuffledKeys(n, 7);
+        w.removes = shuffledKeys(n, 31);
+    }
+    else if(pattern == "zipf") {
+        //one scatter, so the hot keys that are looked up are the ones inserted
+        vector<int> scatter = shuffledKeys(n, 105);
+        w.inserts = zipfKeys(scatter, n, ZIPF_S, 104);
+        w.finds = zipfKeys(scatter, n, ZIPF_S, 7);
+        w.removes = zipfKeys(scatter, n, ZIPF_S, 31);
+    }
+    else {
+        //a full tree, the skew is only in the lookups
+        vector<int> scatter = shuffledKeys(n, 105);
+        w.inserts = shuffledKeys(n, 104);
+        w.finds = zipfKeys(scatter, n, HOT_ZIPF_S, 7);
+        w.removes = zipfKeys(scatter, n, HOT_ZIPF_S, 31);
+    }
+    return w;
+}
+
+template<typename Tree>
+void run(const char* name, const char* pattern, const Workload& w)
+{
+    int n = w.inserts.size();
+
+    {
+        Tree tree;
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            put(tree, w.inserts[i]);
+        }
+        report(name, pattern, "insert", n, n, timer.seconds());
+
+        long long found = 0;
+        timer.restart();
+        for(int i = 0; i < n; ++i) {
+            if(tree.find(w.finds[i]) != tree.end()) {
+                ++found;
+            }
+        }
+        report(name, pattern, "find", n, n, timer.seconds());
+        benchKeep(found);
+
+        // the same lookups in batches of FIND_BATCH keys
+        found = 0;
+        timer.restart();
+        for(int i = 0; i < n; i += FIND_BATCH) {
+            found += findBatch(tree, w.finds, i, min(n, i + FIND_BATCH));
+        }
+        report(name, pattern, "find_many", n, n, timer.seconds());
+        benchKeep(found);
+
+        runFrozen(name, pattern, tree, w.finds);
+
+        long long sum = 0;
+        int visited = 0;
+        timer.restart();
+        for(typename Tree::iterator it = tree.begin(); it != tree.end(); ++it) {
+            sum += it->second;
+            ++visited;
+        }
+        report(name, pattern, "iterate", n, visited, timer.seconds());
+        benchKeep(sum);
+
+        // the same walk backwards, largest key first. rend() has to find the
+        // smallest node, which can be deep in a splay tree, so it is looked up once
+        sum = 0;
+        visited = 0;
+        timer.restart();
+        typename Tree::reverse_iterator rend = tree.rend();
+        for(typename Tree::reverse_iterator it = tree.rbegin(); it != rend; ++it) {
+            sum += it->second;
+            ++visited;
+        }
+        report(name, pattern, "iterate_desc", n, visited, timer.seconds());
+        benchKeep(sum);
+
+        // the whole tree in order again, through for_each
+        SumItems adder;
+        timer.restart();
+        forEach(tree, adder);
+        report(name, pattern, "for_each", n, adder.count, timer.seconds());
+        benchKeep(adder.sum);
+
+        // same walk, but copied out in chunks of SCAN_CHUNK pairs
+        timer.restart();
+        int scanned = scanAll(tree, 0, n);
+        report(name, pattern, "range_scan", n, scanned, timer.seconds());
+
+        timer.restart();
+        tree.clear();
+        report(name, pattern, "clear", n, visited, timer.seconds());
+    }
+
+    if(string(pattern) == "sequential") {
+        const char* ops[] = { "insert_hint_end", "insert_hint_last" };
+        for(int hintLast = 0; hintLast < 2; ++hintLast) {
+            Tree tree;
+            BenchTimer timer;
+            if(appendHinted(tree, w.inserts, hintLast == 1)) {
+                report(name, pattern, ops[hintLast], n, n, timer.seconds());
+            }
+        }
+    }
+
+    // removals get a freshly built tree
+    {
+        Tree tree;
+        for(int i = 0; i < n; ++i) {
+            put(tree, w.inserts[i]);
+        }
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            erase(tree, w.removes[i]);
+        }
+        report(name, pattern, "remove", n, n, timer.seconds());
+    }
+
+    {
+        Tree tree;
+        for(int i = 0; i < n; ++i) {
+            put(tree, w.inserts[i]);
+        }
+        long long found = 0;
+        int ops = 0;
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            erase(tree, w.removes[i]);
+            if(i % 2 == 1) {
+                put(tree, w.removes[i / 2]);
+                ++ops;
+            }
+            if(tree.find(w.finds[i]) != tree.end()) {
+                ++found;
+            }
+            ops += 2;
+        }
+        report(name, pattern, "mixed", n, ops, timer.seconds());
+        benchKeep(found);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int maxN = 10000000;
+    if(argc > 1) {
+        maxN = atoi(argv[1]);
+    }
+
+    const char* patterns[] = { "sequential", "random", "zipf", "hot" };
+
+    cout << "tree,pattern,op,n,ops,seconds,ns_per_op" << endl;
+    for(int n = 1000; n <= maxN; n *= 10) {
+        for(int p = 0; p < 4; ++p) {
+            Workload w = makeWorkload(patterns[p], n);
+            if(p != 0 || n <= SEQUENTIAL_BST_MAX) {
+                run<BinarySearchTree<int, int> >("bst", patterns[p], w);
+            }
+            run<AVLTree<int, int> >("avl", patterns[p], w);
+            run<RedBlackTree<int, int> >("rbtree", patterns[p], w);
+            run<SplayTree<int, int> >("splay", patterns[p], w);
+            run<BTree<int, int> >("btree", patterns[p], w);
+            run<map<int, int> >("std::map", patterns[p], w);
+        }
+        // stop before n * 10 could overflow
+        if(n > maxN / 10) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -1,13 +1,1251 @@
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 #include "bst.h"
 #include "avlbst.h"
+#include "rbbst.h"
+#include "splaybst.h"
+#include "compact-avl.h"
+#include "btree.h"
 
 using namespace std;
 
+// number of failed checks, which is also the exit status
+static int failures = 0;
+
+void check(bool ok, const string& what)
+{
+    if(!ok) {
+        cout << "FAILED: " << what << endl;
+        ++failures;
+    }
+}
+
+// true if tree holds exactly the items of expected, in order
+template<typename Tree, typename Key, typename Value>
+bool sameItems(const Tree& tree, const map<Key, Value>& expected)
+{
+    typename map<Key, Value>::const_iterator want = expected.begin();
+    for(typename Tree::iterator it = tree.begin(); it != tree.end(); ++it, ++want) {
+        if(want == expected.end() || it->first != want->first || it->second != want->second) {
+            return false;
+        }
+    }
+    return want == expected.end();
+}
+
+// true if it, from a container that ends at end, and want from expected point
+// at the same item or are both past the end
+template<typename It, typename Key, typename Value>
+bool samePlace(It it, It end, typename map<Key, Value>::const_iterator want, const map<Key, Value>& expected)
+{
+    if(it == end || want == expected.end()) {
+        return it == end && want == expected.end();
+    }
+    return it->first == want->first && it->second == want->second;
+}
+
+// random inserts and removes over a small key range, so most keys come and go
+// several times; after every step tree has to hold the same items as a std::map
+// and pass valid, the check of its own shape
+template<typename Tree, typename Valid>
+void checkRandomUpdates(Tree& tree, Valid valid, const string& name)
+{
+    map<int,int> expected;
+    mt19937 rng(2024);
+    bool ok = true;
+    for(int step = 0; step < 4000 && ok; ++step) {
+        int key = rng() % 300;
+        if(rng() % 5 < 3) {
+            tree.insert(std::make_pair(key, step));
+            expected[key] = step;
+        }
+        else {
+            tree.remove(key);
+            expected.erase(key);
+        }
+        ok = sameItems(tree, expected) && valid(tree);
+        if(!ok) {
+            cout << name << " went wrong at step " << step << endl;
+        }
+    }
+    check(ok, name + " matches std::map after random inserts and removes");
+}
+
+template<typename Tree>
+bool balanced(const Tree& tree)
+{
+    return tree.isBalanced();
+}
+
+template<typename Tree>
+bool redBlack(const Tree& tree)
+{
+    return tree.isRedBlack();
+}
+
+// select, rank and count_range of the SubtreeSize augmentation, checked against
+// std::map after every batch of mixed inserts, overwrites, emplaces and removes
+void testOrderStatistics()
+{
+    AVLTree<int,int,SlabArena,SubtreeSize> tree;
+    map<int,int> expected;
+    mt19937 rng(11);
+    bool ok = true;
+    for(int step = 0; step < 3000 && ok; ++step) {
+        int key = rng() % 400;
+        switch(rng() % 4) {
+            case 0:
+                tree.insert(std::make_pair(key, step));
+                expected[key] = step;
+                break;
+            case 1:
+                tree.emplace(key, step);
+                expected.emplace(key, step);
+                break;
+            case 2:
+                tree.insert_or_assign(key, -step);
+                expected[key] = -step;
+                break;
+            default:
+                tree.remove(key);
+                expected.erase(key);
+        }
+        if(step % 50 != 0) {
+            continue;
+        }
+
+        size_t k = 0;
+        for(map<int,int>::iterator it = expected.begin(); it != expected.end(); ++it, ++k) {
+            AVLTree<int,int,SlabArena,SubtreeSize>::iterator found = tree.select(k);
+            ok = ok && found != tree.end() && found->first == it->first;
+        }
+        ok = ok && tree.select(expected.size()) == tree.end();
+        for(int key = -1; key <= 401; ++key) {
+            size_t below = distance(expected.begin(), expected.lower_bound(key));
+            ok = ok && tree.rank(key) == below;
+        }
+        for(int i = 0; i < 50; ++i) {
+            int lo = int(rng() % 420) - 10;
+            int hi = lo + int(rng() % 200);
+            size_t inside = distance(expected.lower_bound(lo), expected.lower_bound(hi));
+            ok = ok && tree.count_range(lo, hi) == inside;
+        }
+        ok = ok && tree.isBalanced();
+    }
+    check(ok, "select, rank and count_range match std::map after mixed updates");
+}
+
+// the range constructor and assign build a balanced tree from sorted items,
+// with the subtree sizes filled in, and refuse unsorted or repeated keys
+// without touching the tree
+void testAssign()
+{
+    typedef AVLTree<int,int,SlabArena,SubtreeSize> SizedTree;
+    bool ok = true;
+    SizedTree reused;
+    reused.insert(std::make_pair(-7, -7));
+    for(int n = 0; n <= 1100 && ok; n = (n < 40 ? n + 1 : 2 * n + 1)) {
+        vector<pair<int,int> > items;
+        map<int,int> expected;
+        for(int i = 0; i < n; ++i) {
+            items.push_back(std::make_pair(3 * i, i));
+            expected[3 * i] = i;
+        }
+        SizedTree built(items.begin(), items.end());
+        reused.assign(items.begin(), items.end());
+        ok = sameItems(built, expected) && built.isBalanced() &&
+             sameItems(reused, expected) && reused.isBalanced() &&
+             built.select(n) == built.end();
+        for(int i = 0; i < n && ok; i += 1 + n / 20) {
+            ok = built.select(i)->first == 3 * i && built.rank(3 * i) == size_t(i);
+        }
+
+        //and it has to keep working as a normal tree
+        built.insert(std::make_pair(1, 1));
+        built.remove(0);
+        expected[1] = 1;
+        expected.erase(0);
+        ok = ok && sameItems(built, expected) && built.isBalanced();
+        if(!ok) {
+            cout << "assign went wrong with " << n << " items" << endl;
+        }
+    }
+    check(ok, "AVLTree range constructor and assign build a balanced tree");
+
+    map<int,int> before(reused.begin(), reused.end());
+    vector<pair<int,int> > unsorted;
+    unsorted.push_back(std::make_pair(1, 1));
+    unsorted.push_back(std::make_pair(3, 3));
+    unsorted.push_back(std::make_pair(2, 2));
+    vector<pair<int,int> > repeated;
+    repeated.push_back(std::make_pair(1, 1));
+    repeated.push_back(std::make_pair(1, 2));
+    int threw = 0;
+    try {
+        reused.assign(unsorted.begin(), unsorted.end());
+    }
+    catch(invalid_argument&) {
+        ++threw;
+    }
+    try {
+        reused.assign(repeated.begin(), repeated.end());
+    }
+    catch(invalid_argument&) {
+        ++threw;
+    }
+    try {
+        SizedTree refused(unsorted.begin(), unsorted.end());
+    }
+    catch(invalid_argument&) {
+        ++threw;
+    }
+    check(threw == 3 && sameItems(reused, before) && reused.isBalanced(),
+          "AVLTree assign refuses unsorted or repeated keys and leaves the tree alone");
+}
+
+// aggregate(lo, hi) of an Aggregate augmented tree over random ranges, with
+// Monoid::combine folded over the same std::map range as the reference
+template<typename Monoid>
+void testAggregate(const string& name)
+{
+    typedef typename Monoid::value_type T;
+    AVLTree<int,T,SlabArena,Aggregate<Monoid> > tree;
+    map<int,T> expected;
+    mt19937 rng(17);
+    bool ok = true;
+    for(int step = 0; step < 3000 && ok; ++step) {
+        int key = rng() % 400;
+        T value = T(rng() % 1000) - 500;
+        switch(rng() % 4) {
+            case 0:
+                tree.insert(std::make_pair(key, value));
+                expected[key] = value;
+                break;
+            case 1:
+                tree.insert_or_assign(key, value);
+                expected[key] = value;
+                break;
+            case 2:
+                tree.insert(tree.lower_bound(key), std::make_pair(key, value));
+                expected[key] = value;
+                break;
+            default:
+                tree.remove(key);
+                expected.erase(key);
+        }
+        if(step % 50 != 0) {
+            continue;
+        }
+
+        for(int i = 0; i < 50; ++i) {
+            int lo = int(rng() % 420) - 10;
+            int hi = lo + int(rng() % 200);
+            T want = Monoid::identity();
+            typename map<int,T>::iterator end = expected.lower_bound(hi);
+            for(typename map<int,T>::iterator it = expected.lower_bound(lo); it != end; ++it) {
+                want = Monoid::combine(want, Monoid::lift(it->second));
+            }
+            ok = ok && tree.aggregate(lo, hi) == want;
+        }
+        ok = ok && tree.isBalanced();
+    }
+    check(ok, name + " aggregate matches std::map over random ranges");
+}
+
+// an Aggregate tree only hands out read only values, so every write goes through
+// the tree and keeps the totals right, also through a BinarySearchTree reference
+void testAggregateReadOnly()
+{
+    typedef AVLTree<int,long,SlabArena,Aggregate<SumOf<long> > > SumTree;
+    typedef AVLTree<int,long> PlainTree;
+    typedef const pair<const int,long>& ReadOnlyItem;
+    static_assert(is_same<decltype(declval<SumTree&>()[0]), const long&>::value,
+                  "operator[] of an Aggregate tree is read only");
+    static_assert(is_same<decltype(*declval<SumTree&>().begin()), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().find(0)), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().lower_bound(0)), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().equal_range(0).second), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().rbegin()), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().emplace(0, 0L).first), ReadOnlyItem>::value &&
+                  is_same<decltype(*declval<SumTree&>().insert_or_assign(0, 0L).first), ReadOnlyItem>::value,
+                  "iterators of an Aggregate tree are read only");
+    static_assert(is_same<decltype(declval<PlainTree&>()[0]), long&>::value &&
+                  is_same<decltype(*declval<PlainTree&>().begin()), pair<const int,long>&>::value,
+                  "other AVLTrees keep writable values");
+
+    SumTree tree;
+    map<int,long> expected;
+    for(int i = 0; i < 100; ++i) {
+        tree.insert(std::make_pair(i, long(i)));
+        expected[i] = i;
+    }
+    BinarySearchTree<int,long>& base = tree;
+    base.insert(std::make_pair(10, 1000L));
+    base.insert(base.find(20), std::make_pair(20, 2000L));
+    base.insert_or_assign(30, 3000L);
+    base.emplace(40, 4000L);
+    base.try_emplace(150, 5000L);
+    tree.insert(tree.find(50), std::make_pair(50, 6000L));
+    expected[10] = 1000;
+    expected[20] = 2000;
+    expected[30] = 3000;
+    expected[150] = 5000;
+    expected[50] = 6000;
+
+    bool ok = tree.isBalanced();
+    for(int hi = 0; hi <= 200; hi += 10) {
+        long want = 0;
+        for(map<int,long>::iterator it = expected.begin(); it != expected.lower_bound(hi); ++it) {
+            want += it->second;
+        }
+        ok = ok && tree.aggregate(0, hi) == want;
+    }
+    check(ok, "Aggregate totals follow writes through the tree and a BinarySearchTree reference");
+}
+
+// split at a key below all keys, at a key in the tree, between two keys and above
+// all keys, then join the halves back together; the sizes kept by SubtreeSize
+// have to survive both
+void testSplitJoin()
+{
+    typedef AVLTree<int,int,SlabArena,SubtreeSize> SizedTree;
+    mt19937 rng(18);
+    map<int,int> items;
+    for(int i = 0; i < 500; ++i) {
+        items[2 * int(rng() % 1000)] = i;
+    }
+    map<int,int>::iterator middle = items.begin();
+    advance(middle, items.size() / 2);
+
+    const int cuts[] = { -5, middle->first, middle->first + 1, 5000 };
+    const char* names[] = { "below the keys", "at a key", "between keys", "above the keys" };
+    for(int c = 0; c < 4; ++c) {
+        SizedTree left, right;
+        for(map<int,int>::iterator it = items.begin(); it != items.end(); ++it) {
+            left.insert(*it);
+        }
+        left.split(cuts[c], right);
+
+        map<int,int> low(items.begin(), items.lower_bound(cuts[c]));
+        map<int,int> high(items.lower_bound(cuts[c]), items.end());
+        check(sameItems(left, low) && sameItems(right, high) && left.isBalanced() && right.isBalanced() &&
+              left.count_range(-10, 10000) == low.size() && right.count_range(-10, 10000) == high.size(),
+              string("split ") + names[c]);
+
+        left.join(right);
+        check(sameItems(left, items) && right.empty() && left.isBalanced() &&
+              left.count_range(-10, 10000) == items.size(),
+              string("join after a split ") + names[c]);
+    }
+
+    //keys that overlap are refused and both trees stay as they were
+    SizedTree left, right;
+    left.insert(std::make_pair(1, 1));
+    left.insert(std::make_pair(5, 5));
+    right.insert(std::make_pair(3, 3));
+    bool threw = false;
+    try {
+        left.join(right);
+    }
+    catch(invalid_argument&) {
+        threw = true;
+    }
+    check(threw && left.count_range(0, 10) == 2 && right.count_range(0, 10) == 1, "join refuses overlapping keys");
+}
+
+// fills tree and expected with count random keys below range, all with value tag
+void fillRandom(AVLTree<int,int>& tree, map<int,int>& expected, mt19937& rng, int count, int range, int tag)
+{
+    for(int i = 0; i < count; ++i) {
+        int key = rng() % range;
+        tree.insert(std::make_pair(key, tag));
+        expected[key] = tag;
+    }
+}
+
+// set_union, set_intersection and set_difference against the same operation on
+// two std::maps; for a key in both trees ownWins says which value has to stay
+enum SetOp { UNION, INTERSECTION, DIFFERENCE };
+
+template<typename Resolve>
+void testSetOp(SetOp op, bool ownWins, const string& name)
+{
+    mt19937 rng(19);
+    bool ok = true;
+    for(int round = 0; round < 20 && ok; ++round) {
+        AVLTree<int,int> a, b;
+        map<int,int> inA, inB;
+        //sizes from empty to larger than the other tree
+        fillRandom(a, inA, rng, round * 20, 600, 1);
+        fillRandom(b, inB, rng, (19 - round) * 15, 600, 2);
+
+        map<int,int> expected;
+        for(map<int,int>::iterator it = inA.begin(); it != inA.end(); ++it) {
+            bool shared = inB.count(it->first) > 0;
+            if(op == UNION || (op == INTERSECTION && shared) || (op == DIFFERENCE && !shared)) {
+                expected[it->first] = (shared && !ownWins) ? inB[it->first] : it->second;
+            }
+        }
+        if(op == UNION) {
+            expected.insert(inB.begin(), inB.end());
+        }
+
+        if(op == UNION) {
+            a.set_union(b, Resolve());
+        }
+        else if(op == INTERSECTION) {
+            a.set_intersection(b, Resolve());
+        }
+        else {
+            a.set_difference(b);
+        }
+        ok = sameItems(a, expected) && a.isBalanced() && b.empty();
+
+        //both trees keep working afterwards
+        b.insert(std::make_pair(7, 7));
+        a.insert(std::make_pair(7, 7));
+        ok = ok && b.find(7) != b.end() && a.find(7) != a.end();
+    }
+    check(ok, name + " matches std::map");
+}
+
+// find, lower_bound and upper_bound for every key in and around the items of a
+// FrozenIndex, whose keys are the even numbers 0, 2, ..., so the odd ones miss
+bool frozenMatches(const FrozenIndex<int,int>& index, const map<int,int>& expected)
+{
+    typedef FrozenIndex<int,int>::iterator It;
+    bool ok = sameItems(index, expected) && index.size() == expected.size() &&
+              index.empty() == expected.empty();
+    int top = expected.empty() ? 0 : expected.rbegin()->first;
+    for(int key = -2; key <= top + 2 && ok; ++key) {
+        ok = samePlace<It, int, int>(index.find(key), index.end(), expected.find(key), expected) &&
+             samePlace<It, int, int>(index.lower_bound(key), index.end(), expected.lower_bound(key), expected) &&
+             samePlace<It, int, int>(index.upper_bound(key), index.end(), expected.upper_bound(key), expected);
+    }
+    return ok;
+}
+
+// freeze() at sizes 2^k - 1, 2^k and 2^k + 1, where the bottom level of the
+// implicit tree is full, has one slot or is one slot past full: the bounds strip
+// the walk's last right turns with lastLeftTurn and go wrong first there
+void testFrozenIndex()
+{
+    bool ok = true;
+    mt19937 rng(22);
+    for(int k = 0; k <= 10 && ok; ++k) {
+        for(int n = (1 << k) - 1; n <= (1 << k) + 1; ++n) {
+            AVLTree<int,int> tree;
+            map<int,int> expected;
+            vector<int> order;
+            for(int i = 0; i < n; ++i) {
+                order.push_back(i);
+            }
+            shuffle(order.begin(), order.end(), rng);
+            for(size_t i = 0; i < order.size(); ++i) {
+                tree.insert(std::make_pair(2 * order[i], int(i)));
+                expected[2 * order[i]] = int(i);
+            }
+            FrozenIndex<int,int> index = tree.freeze();
+            if(!frozenMatches(index, expected)) {
+                cout << "FrozenIndex went wrong with " << n << " items" << endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    check(ok, "FrozenIndex find, lower_bound and upper_bound match std::map");
+
+    //freeze(index) replaces what the index held
+    AVLTree<int,int> tree;
+    map<int,int> expected;
+    for(int i = 0; i < 100; ++i) {
+        tree.insert(std::make_pair(2 * i, i));
+        expected[2 * i] = i;
+    }
+    FrozenIndex<int,int> index = tree.freeze();
+    for(int i = 0; i < 100; i += 3) {
+        tree.remove(2 * i);
+        expected.erase(2 * i);
+    }
+    tree.insert(std::make_pair(300, -1));
+    expected[300] = -1;
+    tree.freeze(index);
+    check(frozenMatches(index, expected), "FrozenIndex rebuilt through freeze(index)");
+
+    //unsorted or repeated keys are refused and leave the index as it was
+    vector<pair<int,int> > unsorted;
+    unsorted.push_back(std::make_pair(4, 0));
+    unsorted.push_back(std::make_pair(2, 0));
+    vector<pair<int,int> > repeated;
+    repeated.push_back(std::make_pair(2, 0));
+    repeated.push_back(std::make_pair(2, 1));
+    int threw = 0;
+    try {
+        index.assign(unsorted.begin(), unsorted.end());
+    }
+    catch(invalid_argument&) {
+        ++threw;
+    }
+    try {
+        index.assign(std::move(repeated));
+    }
+    catch(invalid_argument&) {
+        ++threw;
+    }
+    check(threw == 2 && frozenMatches(index, expected), "FrozenIndex assign refuses unsorted keys");
+
+    //an empty tree freezes into an empty index
+    tree.clear();
+    tree.freeze(index);
+    check(frozenMatches(index, map<int,int>()) && index.begin() == index.end(), "FrozenIndex of an empty tree");
+}
+
+// lower_bound, upper_bound and equal_range for every key in and around the
+// items, which are random even keys so that every odd key misses
+template<typename Tree>
+void testBounds(const string& name)
+{
+    typedef typename Tree::iterator It;
+    Tree tree;
+    map<int,int> expected;
+    mt19937 rng(12);
+    bool ok = true;
+    for(int i = 0; i < 400 && ok; ++i) {
+        //the checks run on the way up from an empty tree
+        if(i % 40 == 0) {
+            for(int key = -2; key <= 402 && ok; ++key) {
+                pair<It, It> range = tree.equal_range(key);
+                ok = samePlace<It, int, int>(tree.lower_bound(key), tree.end(), expected.lower_bound(key), expected) &&
+                     samePlace<It, int, int>(tree.upper_bound(key), tree.end(), expected.upper_bound(key), expected) &&
+                     samePlace<It, int, int>(range.first, tree.end(), expected.equal_range(key).first, expected) &&
+                     samePlace<It, int, int>(range.second, tree.end(), expected.equal_range(key).second, expected);
+                if(!ok) {
+                    cout << name << " bounds went wrong at key " << key << " with " << expected.size() << " items" << endl;
+                }
+            }
+        }
+        int key = 2 * (rng() % 200);
+        tree.insert(std::make_pair(key, i));
+        expected[key] = i;
+    }
+    check(ok, name + " lower_bound, upper_bound and equal_range match std::map");
+}
+
+// walks tree backwards with reverse_iterator, with operator-- from end() and
+// with const_reverse_iterator, and forwards with const_iterator; all have to
+// give the items of expected in the same order as std::map
+template<typename Tree>
+bool sameWalks(const Tree& tree, const map<int,int>& expected)
+{
+    vector<pair<int,int> > forward(expected.begin(), expected.end());
+    vector<pair<int,int> > backward(expected.rbegin(), expected.rend());
+
+    vector<pair<int,int> > reversed;
+    for(typename Tree::reverse_iterator it = tree.rbegin(); it != tree.rend(); ++it) {
+        reversed.push_back(*it);
+    }
+    vector<pair<int,int> > stepped;
+    for(typename Tree::iterator it = tree.end(); it != tree.begin(); ) {
+        it--;
+        stepped.push_back(*it);
+    }
+    vector<pair<int,int> > constReversed;
+    for(typename Tree::const_reverse_iterator it = tree.crbegin(); it != tree.crend(); ++it) {
+        constReversed.push_back(*it);
+    }
+    vector<pair<int,int> > constForward;
+    for(typename Tree::const_iterator it = tree.cbegin(); it != tree.cend(); it++) {
+        constForward.push_back(std::make_pair(it->first, it->second));
+    }
+    bool ok = reversed == backward && stepped == backward && constReversed == backward && constForward == forward;
+
+    //--end() is the largest item, also after the largest one was removed
+    if(!expected.empty()) {
+        typename Tree::iterator last = tree.end();
+        --last;
+        typename Tree::const_iterator constLast = tree.cend();
+        constLast--;
+        ok = ok && last->first == expected.rbegin()->first && constLast->first == expected.rbegin()->first;
+    }
+    return ok;
+}
+
+// reverse and const iteration after every batch of random inserts and removes,
+// which keep replacing the largest key
+template<typename Tree>
+void testIterators(const string& name)
+{
+    Tree tree;
+    map<int,int> expected;
+    mt19937 rng(14);
+    bool ok = sameWalks(tree, expected) && tree.rbegin() == tree.rend();
+    for(int round = 0; round < 40 && ok; ++round) {
+        for(int i = 0; i < 20; ++i) {
+            int key = rng() % 200;
+            if(rng() % 3 == 0) {
+                tree.remove(key);
+                expected.erase(key);
+                tree.remove(expected.empty() ? 0 : expected.rbegin()->first);
+                if(!expected.empty()) {
+                    expected.erase(--expected.end());
+                }
+            }
+            else {
+                tree.insert(std::make_pair(key, i));
+                expected[key] = i;
+            }
+        }
+        ok = sameWalks(tree, expected);
+    }
+    check(ok, name + " reverse and const iterators match std::map");
+}
+
+// findMany has to give the same iterator as find for every key of a batch,
+// hits and misses mixed; the batch sizes straddle the groups of 16 walks
+void testFindMany()
+{
+    AVLTree<int,int> tree;
+    AVLTree<int,int> empty;
+    mt19937 rng(16);
+    for(int i = 0; i < 500; ++i) {
+        int key = 2 * (rng() % 1000);
+        tree.insert(std::make_pair(key, i));
+    }
+
+    bool ok = true;
+    size_t sizes[] = { 0, 1, 7, 15, 16, 17, 31, 32, 33, 100, 257 };
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        vector<int> keys;
+        for(size_t i = 0; i < sizes[s]; ++i) {
+            keys.push_back(int(rng() % 2010) - 5);
+        }
+        //results from an earlier batch are replaced
+        vector<AVLTree<int,int>::iterator> results(3, tree.begin());
+        vector<AVLTree<int,int>::iterator> emptyResults;
+        tree.findMany(keys, results);
+        empty.findMany(keys, emptyResults);
+        ok = ok && results.size() == keys.size() && emptyResults.size() == keys.size();
+        for(size_t i = 0; i < keys.size() && ok; ++i) {
+            ok = results[i] == tree.find(keys[i]) && emptyResults[i] == empty.end();
+        }
+        if(!ok) {
+            cout << "findMany went wrong with a batch of " << sizes[s] << " keys" << endl;
+            break;
+        }
+    }
+    check(ok, "findMany matches find");
+}
+
+// KeySearch<K>::lower and upper against std::lower_bound and std::upper_bound on
+// sorted arrays of 0 to 70 keys, so whole SIMD blocks and the leftover tail both
+// run. The keys mix small values with ones near the top and bottom of K, where a
+// missing flip of the top bit for unsigned keys would break the order
+template<typename K>
+void testKeySearch(const string& name)
+{
+    const K low = numeric_limits<K>::min();
+    const K high = numeric_limits<K>::max();
+    const K edges[] = { low, K(low + 1), K(-1), K(0), K(1), K(high / 2), K(high / 2 + 1), K(high - 1), high };
+    mt19937_64 rng(23);
+    bool ok = true;
+    for(int count = 0; count <= 70 && ok; ++count) {
+        vector<K> keys;
+        while(keys.size() < size_t(count)) {
+            K key = (rng() % 3 == 0) ? edges[rng() % 9] : K(rng() % 200) + K(rng() % 2 ? low : K(0));
+            if(find(keys.begin(), keys.end(), key) == keys.end()) {
+                keys.push_back(key);
+            }
+        }
+        sort(keys.begin(), keys.end());
+
+        vector<K> needles(edges, edges + 9);
+        for(size_t i = 0; i < keys.size(); ++i) {
+            needles.push_back(keys[i]);
+            if(keys[i] != low) {
+                needles.push_back(keys[i] - 1);
+            }
+            if(keys[i] != high) {
+                needles.push_back(keys[i] + 1);
+            }
+        }
+        const K* data = keys.empty() ? NULL : &keys[0];
+        for(size_t i = 0; i < needles.size() && ok; ++i) {
+            int lower = lower_bound(keys.begin(), keys.end(), needles[i]) - keys.begin();
+            int upper = upper_bound(keys.begin(), keys.end(), needles[i]) - keys.begin();
+            ok = KeySearch<K>::lower(data, count, needles[i]) == lower &&
+                 KeySearch<K>::upper(data, count, needles[i]) == upper;
+            if(!ok) {
+                cout << name << " key search went wrong with " << count << " keys" << endl;
+            }
+        }
+    }
+    check(ok, name + " KeySearch matches std::lower_bound and std::upper_bound");
+}
+
+// for_each has to visit exactly the items of std::map, in order, after every
+// batch of random inserts and removes, starting from the empty tree
+template<typename Tree>
+void testForEach(const string& name)
+{
+    Tree tree;
+    map<int,int> expected;
+    mt19937 rng(15);
+    bool ok = true;
+    for(int round = 0; round < 30 && ok; ++round) {
+        vector<pair<int,int> > visited;
+        tree.for_each([&visited](const pair<const int,int>& item) { visited.push_back(item); });
+        ok = visited == vector<pair<int,int> >(expected.begin(), expected.end());
+
+        for(int i = 0; i < 40; ++i) {
+            int key = rng() % 500;
+            if(rng() % 4 == 0) {
+                tree.remove(key);
+                expected.erase(key);
+            }
+            else {
+                tree.insert(std::make_pair(key, i));
+                expected[key] = i;
+            }
+        }
+    }
+    check(ok, name + " for_each visits the items of std::map in order");
+}
+
+// the items with lo <= key < hi collected through rangeScan in chunks of at
+// most chunk, with one cursor resumed until a call returns 0
+template<typename Tree>
+vector<pair<int,int> > scanRange(const Tree& tree, int lo, int hi, size_t chunk, typename Tree::ScanCursor& cursor)
+{
+    vector<pair<int,int> > items;
+    vector<pair<int,int> > buffer(chunk);
+    size_t got;
+    while((got = tree.rangeScan(lo, hi, &buffer[0], chunk, cursor)) > 0) {
+        items.insert(items.end(), buffer.begin(), buffer.begin() + got);
+    }
+    return items;
+}
+
+// rangeScan over random [lo, hi) ranges, in chunks of 1 to 8 items, against the
+// same range of a std::map; empty ranges and trees hand out nothing
+void testRangeScan()
+{
+    AVLTree<int,int> tree;
+    map<int,int> expected;
+    mt19937 rng(13);
+    for(int i = 0; i < 300; ++i) {
+        int key = rng() % 1000;
+        tree.insert(std::make_pair(key, i));
+        expected[key] = i;
+    }
+
+    bool ok = true;
+    for(int round = 0; round < 500 && ok; ++round) {
+        int lo = int(rng() % 1010) - 5;
+        int hi = int(rng() % 1010) - 5;
+        size_t chunk = 1 + rng() % 8;
+        AVLTree<int,int>::ScanCursor cursor;
+        vector<pair<int,int> > items = scanRange(tree, lo, hi, chunk, cursor);
+        vector<pair<int,int> > want;
+        if(lo < hi) {
+            want.assign(expected.lower_bound(lo), expected.lower_bound(hi));
+        }
+        ok = items == want && cursor.done();
+        if(!ok) {
+            cout << "rangeScan went wrong on [" << lo << ", " << hi << ") in chunks of " << chunk << endl;
+        }
+    }
+    check(ok, "rangeScan matches std::map");
+
+    //a cursor is not done before its scan, and after reset() it starts over
+    AVLTree<int,int>::ScanCursor cursor;
+    pair<int,int> buffer[4];
+    ok = !cursor.done() && tree.rangeScan(100, 200, buffer, 4, cursor) == 4 && !cursor.done();
+    scanRange(tree, 100, 200, 4, cursor);
+    ok = ok && cursor.done() && tree.rangeScan(100, 200, buffer, 4, cursor) == 0;
+    cursor.reset();
+    ok = ok && !cursor.done();
+    vector<pair<int,int> > again = scanRange(tree, 500, 600, 5, cursor);
+    vector<pair<int,int> > want(expected.lower_bound(500), expected.lower_bound(600));
+    check(ok && again == want, "rangeScan cursor done() and reset()");
+
+    AVLTree<int,int> empty;
+    AVLTree<int,int>::ScanCursor emptyTree, emptyRange, backwards;
+    check(scanRange(empty, 0, 100, 4, emptyTree).empty() && emptyTree.done(), "rangeScan of an empty tree");
+    check(scanRange(tree, 600, 600, 4, emptyRange).empty() && scanRange(tree, 700, 600, 4, backwards).empty(),
+          "rangeScan of an empty range");
+}
+
+// insert_parallel has to give the same result as inserting the batch in order:
+// the last item of a key wins, also over a key already in the tree. A batch needs
+// 16384 items per part, so the big one is cut into three parts.
+void testInsertParallel(size_t count, const string& name)
+{
+    AVLTree<int,int> tree;
+    map<int,int> expected;
+    for(int key = 0; key < 40000; key += 7) {
+        tree.insert(std::make_pair(key, -1));
+        expected[key] = -1;
+    }
+
+    mt19937 rng(20);
+    vector<pair<int,int> > items;
+    for(size_t i = 0; i < count; ++i) {
+        int key = rng() % 40000;
+        items.push_back(std::make_pair(key, int(i)));
+        expected[key] = int(i);
+    }
+    tree.insert_parallel(items, 4);
+    bool ok = sameItems(tree, expected) && tree.isBalanced();
+
+    //the nodes built by the threads can be removed and replaced as usual
+    for(int key = 0; key < 40000; key += 3) {
+        tree.remove(key);
+        expected.erase(key);
+    }
+    tree.insert(std::make_pair(3, 3));
+    expected[3] = 3;
+    ok = ok && sameItems(tree, expected) && tree.isBalanced();
+    check(ok, name + " matches inserting one by one");
+}
+
+// builds a BinarySearchTree from keys in the given order
+BinarySearchTree<int,int>* treeOf(const int* keys, int count)
+{
+    BinarySearchTree<int,int>* tree = new BinarySearchTree<int,int>;
+    for(int i = 0; i < count; ++i) {
+        tree->insert(std::make_pair(keys[i], i));
+    }
+    return tree;
+}
+
+// equalPaths() on small trees with and without equal leaf depths, where the
+// first or only the last leaf is off, and on a path of a million nodes
+void testEqualPaths()
+{
+    //    8
+    //  4    12
+    // 2 6  10 14
+    const int full[] = { 8, 4, 12, 2, 6, 10, 14 };
+    //the first leaf, 4, is one level above the rest
+    const int firstOff[] = { 8, 4, 12, 10, 14 };
+    //only the last leaf, 12, is one level above the rest
+    const int lastOff[] = { 8, 4, 12, 2, 6 };
+    //13 hangs one level below the rest
+    const int oneDeeper[] = { 8, 4, 12, 2, 6, 10, 14, 13 };
+    //3 and 7 fill in the left side, 2 and 6 are no longer leaves
+    const int bothSides[] = { 8, 4, 12, 2, 6, 10, 14, 3, 7, 9, 15 };
+
+    BinarySearchTree<int,int> empty;
+    BinarySearchTree<int,int>* trees[] = { treeOf(full, 7), treeOf(full, 1), treeOf(full, 2), treeOf(firstOff, 5),
+                                           treeOf(lastOff, 5), treeOf(oneDeeper, 8), treeOf(bothSides, 11) };
+    const bool expected[] = { true, true, true, false, false, false, true };
+    bool ok = empty.equalPaths();
+    for(int i = 0; i < 7; ++i) {
+        if(trees[i]->equalPaths() != expected[i]) {
+            cout << "equalPaths() went wrong on tree " << i << endl;
+            ok = false;
+        }
+        delete trees[i];
+    }
+    check(ok, "equalPaths() on small trees");
+
+    //a path far deeper than the call stack could take, then a leaf off its top
+    BinarySearchTree<int,int> list;
+    for(int key = 0; key < 1000000; ++key) {
+        list.insert(list.end(), std::make_pair(key, key));
+    }
+    ok = list.equalPaths();
+    list.insert(std::make_pair(-1, -1));
+    check(ok && !list.equalPaths(), "equalPaths() on a path of a million nodes");
+}
+
+// a value that counts how many of it are alive, so a clear that skips or
+// repeats a destructor shows up
+struct Tracked
+{
+    static long alive;
+    int id;
+    Tracked(int i) : id(i) { ++alive; }
+    Tracked(const Tracked& other) : id(other.id) { ++alive; }
+    ~Tracked() { --alive; }
+    Tracked& operator=(const Tracked& other) { id = other.id; return *this; }
+};
+
+long Tracked::alive = 0;
+
+// clear() of a list of millions of nodes, built by appending through
+// insert(end(), ...), must not run out of stack. With SlabArena and an int
+// value nothing is walked, with Tracked the nodes are only destructed before
+// the slabs go at once, and HeapAllocator frees them one by one
+template<typename Alloc, typename Value>
+bool clearsList(int count)
+{
+    BinarySearchTree<int, Value, Alloc> tree;
+    long aliveBefore = Tracked::alive;
+    for(int key = 0; key < count; ++key) {
+        tree.insert(tree.end(), std::make_pair(key, Value(key)));
+    }
+    bool ok = tree.balanceReport().height == count;
+    tree.clear();
+    ok = ok && tree.empty() && tree.begin() == tree.end() && Tracked::alive == aliveBefore;
+
+    //the tree is usable again
+    tree.insert(tree.end(), std::make_pair(1, Value(1)));
+    return ok && tree.find(1) != tree.end() && ++tree.begin() == tree.end();
+}
+
+void testClearList()
+{
+    const int count = 2000000;
+    check(clearsList<SlabArena, int>(count), "clear of a long list with SlabArena");
+    check(clearsList<SlabArena, Tracked>(count), "clear of a long list of Tracked values with SlabArena");
+    check(clearsList<HeapAllocator, int>(count), "clear of a long list with HeapAllocator");
+    check(clearsList<HeapAllocator, Tracked>(count), "clear of a long list of Tracked values with HeapAllocator");
+}
+
+// balanceReport on shapes worked out by hand: height counts the nodes on the
+// longest path and offender is the first unbalanced node in post order
+void testBalanceReport()
+{
+    typedef BinarySearchTree<int,int>::BalanceReport Report;
+    BinarySearchTree<int,int> tree;
+    Report report = tree.balanceReport();
+    check(report.balanced && report.height == 0 && report.offender == NULL, "balanceReport of an empty tree");
+
+    //    50
+    //   30  70
+    //  20  60
+    // 10
+    //30 has two levels on its left and none on its right
+    int keys[] = { 50, 30, 70, 20, 10, 60 };
+    for(int i = 0; i < 6; ++i) {
+        tree.insert(std::make_pair(keys[i], i));
+    }
+    report = tree.balanceReport();
+    check(!report.balanced && report.height == 4 && report.offender != NULL && report.offender->getKey() == 30,
+          "balanceReport names 30 as the offender at height 4");
+
+    //40 evens out 30, and 50 has heights 3 and 2
+    tree.insert(std::make_pair(40, 6));
+    report = tree.balanceReport();
+    check(report.balanced && report.height == 4 && report.offender == NULL, "balanceReport after the tree is balanced");
+
+    //1 to 5 in order is a list; 5 and 4 are fine, 3 is the first offender
+    BinarySearchTree<int,int> list;
+    for(int key = 1; key <= 5; ++key) {
+        list.insert(std::make_pair(key, key));
+    }
+    report = list.balanceReport();
+    check(!report.balanced && report.height == 5 && report.offender != NULL && report.offender->getKey() == 3,
+          "balanceReport names the lowest offender of a list");
+}
+
+// emplace, the hinted insert and friends called through a BinarySearchTree
+// reference have to build the derived tree's own nodes and rebalance
+template<typename Tree>
+void testBaseEmplace(Tree& tree, const string& name)
+{
+    BinarySearchTree<int,int>& base = tree;
+    map<int,int> expected;
+    for(int i = 0; i < 100; ++i) {
+        base.emplace(i, i);
+        base.try_emplace(i + 100, i);
+        base.insert_or_assign(i / 2, -i);
+        expected.emplace(i, i);
+        expected.emplace(i + 100, i);
+        expected[i / 2] = -i;
+    }
+    BinarySearchTree<int,int>::iterator hint = base.end();
+    for(int i = 200; i < 300; ++i) {
+        hint = base.insert(hint, std::make_pair(i, i));
+        expected[i] = i;
+    }
+    check(!base.try_emplace(5, 0).second && !base.emplace(5, 0).second, name + " emplace kept an existing key");
+    check(sameItems(tree, expected), name + " emplace through the base class");
+}
+
+// a value that counts how often it is copied or moved, and how many are alive
+struct Counted
+{
+    static int copies;
+    static int alive;
+    int id;
+    Counted(int i) : id(i) { ++alive; }
+    Counted(const Counted& other) : id(other.id) { ++copies; ++alive; }
+    Counted(Counted&& other) : id(other.id) { ++copies; ++alive; }
+    ~Counted() { --alive; }
+    Counted& operator=(const Counted& other) { id = other.id; ++copies; return *this; }
+};
+
+int Counted::copies = 0;
+int Counted::alive = 0;
+
+// emplace builds the new node's item straight from its arguments, like std::map,
+// so the value is never copied or moved, not even when the key is already there
+// and the node is thrown away again
+template<typename Tree, typename Valid>
+void testEmplaceInPlace(Valid valid, const string& name)
+{
+    int aliveBefore = Counted::alive;
+    {
+        //CompactAVLTree moves its items when its pool grows, so that is done first
+        Tree tree;
+        for(int key = 1000; key < 1300; ++key) {
+            tree.emplace(key, 0);
+        }
+        for(int key = 1000; key < 1300; ++key) {
+            tree.remove(key);
+        }
+        map<int,int> expected;
+        int copiesBefore = Counted::copies;
+        bool ok = true;
+        for(int i = 0; i < 200; ++i) {
+            //the first 101 steps reach every key once, the rest hit existing keys
+            int key = (i * 37) % 101;
+            ok = ok && tree.emplace(key, i).second == (i < 101);
+            expected.emplace(key, i);
+        }
+        ok = ok && tree.emplace(std::piecewise_construct, std::forward_as_tuple(200), std::forward_as_tuple(7)).second;
+        ok = ok && tree.emplace(std::make_pair(201, 8)).second;
+        expected[200] = 7;
+        expected[201] = 8;
+        check(ok && Counted::copies == copiesBefore, name + " emplace builds the value in place");
+
+        map<int,int>::iterator want = expected.begin();
+        for(typename Tree::iterator it = tree.begin(); it != tree.end() && ok; ++it, ++want) {
+            ok = want != expected.end() && it->first == want->first && it->second.id == want->second;
+        }
+        check(ok && want == expected.end() && valid(tree), name + " emplace keeps the first value of a key");
+    }
+    check(Counted::alive == aliveBefore, name + " emplace destroys the node of an existing key");
+}
+
+// an arena is sized by its first object and refuses larger ones
+void testSlabArena()
+{
+    SlabArena arena;
+    void* small = arena.allocate(16);
+    bool threw = false;
+    try {
+        arena.allocate(64);
+    }
+    catch(invalid_argument&) {
+        threw = true;
+    }
+    check(threw, "SlabArena refuses an object larger than its slots");
+    arena.deallocate(small, 16);
+    check(arena.allocate(16) == small, "SlabArena reuses a freed slot");
+}
+
+// the two halves of a split share an arena group but must still be usable
+// from two threads at once (run under -fsanitize=thread to see races)
+void updateHalf(AVLTree<int,int>* tree, map<int,int>* expected, int first)
+{
+    for(int i = first; i < first + 2000; i += 3) {
+        tree->remove(i);
+        expected->erase(i);
+    }
+    for(int i = first + 100000; i < first + 103000; ++i) {
+        tree->insert(std::make_pair(i, i));
+        (*expected)[i] = i;
+    }
+}
+
+void testSplitThreads()
+{
+    AVLTree<int,int> left, right;
+    map<int,int> leftItems, rightItems;
+    for(int i = 0; i < 4000; ++i) {
+        left.insert(std::make_pair(i, i));
+        (i < 2000 ? leftItems : rightItems)[i] = i;
+    }
+    left.split(2000, right);
+
+    thread worker(updateHalf, &right, &rightItems, 2000);
+    updateHalf(&left, &leftItems, 0);
+    worker.join();
+
+    check(sameItems(left, leftItems) && left.isBalanced(), "left half updated in its own thread");
+    check(sameItems(right, rightItems) && right.isBalanced(), "right half updated in its own thread");
+}
+
+// a key whose copy throws once copiesLeft runs out
+static int copiesLeft = -1;
+
+struct FragileKey
+{
+    int id;
+    string text;
+    FragileKey(int i) : id(i), text(40, 'k') {}
+    FragileKey(const FragileKey& other) : id(other.id), text(other.text) {
+        if(copiesLeft >= 0 && copiesLeft-- == 0) {
+            throw runtime_error("copy failed");
+        }
+    }
+    bool operator<(const FragileKey& other) const { return id < other.id; }
+    bool operator==(const FragileKey& other) const { return id == other.id; }
+};
+
+// an insert whose copy throws, in a fresh slot, a recycled one or while the
+// pool grows, has to leave CompactAVLTree as it was
+void testCompactAVLThrowingCopy()
+{
+    bool ok = true;
+    for(int failAt = 0; failAt < 100; ++failAt) {
+        CompactAVLTree<FragileKey,int> tree;
+        for(int i = 0; i < 30; ++i) {
+            tree.insert(std::make_pair(FragileKey(i), i));
+        }
+        for(int i = 0; i < 30; i += 3) {
+            tree.remove(FragileKey(i));
+        }
+
+        vector<pair<const FragileKey, int> > items;
+        for(int i = 30; i < 90; ++i) {
+            items.push_back(std::make_pair(FragileKey(i), i));
+        }
+
+        int inserted = 0;
+        copiesLeft = failAt;
+        for(size_t i = 0; i < items.size(); ++i) {
+            try {
+                tree.insert(items[i]);
+                ++inserted;
+            }
+            catch(runtime_error&) {
+            }
+        }
+        copiesLeft = -1;
+
+        int count = 0;
+        for(CompactAVLTree<FragileKey,int>::iterator it = tree.begin(); it != tree.end(); ++it) {
+            ++count;
+        }
+        ok = ok && tree.isBalanced() && count == 20 + inserted;
+    }
+    check(ok, "CompactAVLTree unchanged by an insert whose copy throws");
+}
+
+// exposes the root, to see what a SplayTree lookup splayed
+struct SplayProbe : public SplayTree<int,int>
+{
+    int rootKey() const { return root_->getKey(); }
+};
+
+// splay trees keep no shape to check, the order is covered by sameItems
+template<typename Tree>
+bool anyShape(const Tree&)
+{
+    return true;
+}
+
+// find moves the key it hits to the root, and on a miss the last node on the
+// search path, which holds the next key below or above the missing one
+void testSplayToRoot()
+{
+    SplayProbe tree;
+    map<int,int> expected;
+    mt19937 rng(7);
+    for(int i = 0; i < 200; ++i) {
+        int key = rng() % 1000;
+        tree.insert(std::make_pair(key, i));
+        expected[key] = i;
+    }
+
+    bool hits = true;
+    bool misses = true;
+    for(int i = 0; i < 2000; ++i) {
+        int key = rng() % 1000;
+        bool found = tree.find(key) != tree.end();
+        map<int,int>::iterator above = expected.lower_bound(key);
+        if(above != expected.end() && above->first == key) {
+            hits = hits && found && tree.rootKey() == key;
+            continue;
+        }
+
+        bool nextToKey = above != expected.end() && tree.rootKey() == above->first;
+        if(above != expected.begin()) {
+            --above;
+            nextToKey = nextToKey || tree.rootKey() == above->first;
+        }
+        misses = misses && !found && nextToKey;
+    }
+    check(hits, "SplayTree find moves the key to the root");
+    check(misses, "SplayTree find of a missing key moves a neighbour to the root");
+    check(sameItems(tree, expected), "SplayTree items unchanged by splaying");
+}
+
+// a move-only Value works with everything but the copying insert, which throws
+void testMoveOnlyValue()
+{
+    AVLTree<int, unique_ptr<int> > tree;
+    for(int i = 0; i < 20; ++i) {
+        tree.emplace(i, unique_ptr<int>(new int(i)));
+    }
+    tree.insert_or_assign(3, unique_ptr<int>(new int(33)));
+    tree.insert(std::make_pair(30, unique_ptr<int>(new int(30))));
+    tree.remove(4);
+    check(*tree.find(3)->second == 33 && *tree.find(30)->second == 30 && tree.find(4) == tree.end(),
+          "AVLTree with a move-only value");
+
+    bool threw = false;
+    try {
+        const pair<const int, unique_ptr<int> > item(40, unique_ptr<int>());
+        tree.insert(item);
+    }
+    catch(logic_error&) {
+        threw = true;
+    }
+    check(threw && tree.find(40) == tree.end(), "copying a move-only value throws");
+}
+
+// the move aware inserts of CompactAVLTree with a move-only value, while the pool
+// grows: try_emplace leaves its arguments alone for an existing key and
+// insert_or_assign overwrites
+void testCompactMoveAware()
+{
+    CompactAVLTree<int, unique_ptr<int> > tree;
+    map<int,int> expected;
+    bool ok = true;
+    for(int i = 0; i < 100; ++i) {
+        //the first 61 steps reach every key once, the rest hit existing keys
+        int key = (i * 37) % 61;
+        unique_ptr<int> value(new int(i));
+        bool inserted = tree.try_emplace(key, std::move(value)).second;
+        ok = ok && inserted == (i < 61) && (value.get() == NULL) == inserted;
+        expected.emplace(key, i);
+    }
+    ok = ok && !tree.insert_or_assign(5, unique_ptr<int>(new int(500))).second;
+    ok = ok && tree.insert_or_assign(70, unique_ptr<int>(new int(700))).second;
+    tree.insert(std::make_pair(71, unique_ptr<int>(new int(710))));
+    expected[5] = 500;
+    expected[70] = 700;
+    expected[71] = 710;
+
+    map<int,int>::iterator want = expected.begin();
+    for(CompactAVLTree<int, unique_ptr<int> >::const_iterator it = tree.cbegin(); it != tree.cend() && ok; ++it, ++want) {
+        ok = want != expected.end() && it->first == want->first && *it->second == want->second;
+    }
+    check(ok && want == expected.end() && tree.isBalanced(),
+          "CompactAVLTree try_emplace and insert_or_assign with a move-only value");
+}
+
 
 int main(int argc, char *argv[])
 {
+    testSlabArena();
+
     // Binary Search Tree tests
     BinarySearchTree<char,int> bt;
     bt.insert(std::make_pair('a',1));
@@ -26,6 +1264,16 @@ int main(int argc, char *argv[])
     cout << "Erasing b" << endl;
     bt.remove('b');
 
+    BinarySearchTree<int,int> baseEmplace;
+    testBaseEmplace(baseEmplace, "BinarySearchTree");
+    testEmplaceInPlace<BinarySearchTree<int,Counted> >(anyShape<BinarySearchTree<int,Counted> >, "BinarySearchTree");
+    testBounds<BinarySearchTree<int,int> >("BinarySearchTree");
+    testIterators<BinarySearchTree<int,int> >("BinarySearchTree");
+    testForEach<BinarySearchTree<int,int> >("BinarySearchTree");
+    testBalanceReport();
+    testClearList();
+    testEqualPaths();
+
     // AVL Tree Tests
     AVLTree<char,int> at;
     at.insert(std::make_pair('a',1));
@@ -44,5 +1292,76 @@ int main(int argc, char *argv[])
     cout << "Erasing b" << endl;
     at.remove('b');
 
-    return 0;
+    AVLTree<int,int> avlEmplace;
+    testBaseEmplace(avlEmplace, "AVLTree");
+    check(avlEmplace.isBalanced(), "AVLTree balanced after inserts through the base class");
+    testEmplaceInPlace<AVLTree<int,Counted> >(balanced<AVLTree<int,Counted> >, "AVLTree");
+    AVLTree<int,int> avlUpdates;
+    checkRandomUpdates(avlUpdates, balanced<AVLTree<int,int> >, "AVLTree");
+    testOrderStatistics();
+    testAssign();
+    testAggregate<SumOf<long> >("SumOf");
+    testAggregate<MinOf<int> >("MinOf");
+    testAggregate<MaxOf<int> >("MaxOf");
+    testAggregateReadOnly();
+    testMoveOnlyValue();
+    testInsertParallel(3 * 16384 + 500, "insert_parallel of three parts");
+    testInsertParallel(1000, "insert_parallel of a small batch");
+    testSplitThreads();
+    testSplitJoin();
+    testSetOp<KeepOwnValue>(UNION, true, "set_union keeping own values");
+    testSetOp<TakeOtherValue>(UNION, false, "set_union taking other values");
+    testSetOp<KeepOwnValue>(INTERSECTION, true, "set_intersection keeping own values");
+    testSetOp<TakeOtherValue>(INTERSECTION, false, "set_intersection taking other values");
+    testSetOp<KeepOwnValue>(DIFFERENCE, true, "set_difference");
+    testBounds<AVLTree<int,int> >("AVLTree");
+    testFindMany();
+    testForEach<AVLTree<int,int> >("AVLTree");
+    testIterators<AVLTree<int,int> >("AVLTree");
+    testFrozenIndex();
+    testRangeScan();
+
+    // Red-Black Tree Tests
+    RedBlackTree<int,int> rbUpdates;
+    checkRandomUpdates(rbUpdates, redBlack<RedBlackTree<int,int> >, "RedBlackTree");
+    testIterators<RedBlackTree<int,int> >("RedBlackTree");
+
+    RedBlackTree<int,int> rbEmplace;
+    testBaseEmplace(rbEmplace, "RedBlackTree");
+    check(rbEmplace.isRedBlack(), "RedBlackTree valid after inserts through the base class");
+    testEmplaceInPlace<RedBlackTree<int,Counted> >(redBlack<RedBlackTree<int,Counted> >, "RedBlackTree");
+
+    // Splay Tree Tests
+    SplayTree<int,int> splayUpdates;
+    checkRandomUpdates(splayUpdates, anyShape<SplayTree<int,int> >, "SplayTree");
+    testSplayToRoot();
+    testIterators<SplayTree<int,int> >("SplayTree");
+
+    SplayTree<int,int> splayEmplace;
+    testBaseEmplace(splayEmplace, "SplayTree");
+    testEmplaceInPlace<SplayTree<int,Counted> >(anyShape<SplayTree<int,Counted> >, "SplayTree");
+
+    // Compact AVL Tree Tests
+    CompactAVLTree<int,int> compactUpdates;
+    checkRandomUpdates(compactUpdates, balanced<CompactAVLTree<int,int> >, "CompactAVLTree");
+    testCompactAVLThrowingCopy();
+    testCompactMoveAware();
+    testEmplaceInPlace<CompactAVLTree<int,Counted> >(balanced<CompactAVLTree<int,Counted> >, "CompactAVLTree");
+    testBounds<CompactAVLTree<int,int> >("CompactAVLTree");
+    testIterators<CompactAVLTree<int,int> >("CompactAVLTree");
+
+    // B-Tree Tests, fanout 4 splits and merges nodes on most updates
+    testKeySearch<int>("int");
+    testKeySearch<unsigned>("unsigned");
+    testKeySearch<long long>("long long");
+    testKeySearch<uint64_t>("uint64_t");
+    BTree<int,int> btreeUpdates;
+    checkRandomUpdates(btreeUpdates, balanced<BTree<int,int> >, "BTree");
+    BTree<int,int,4> narrowUpdates;
+    checkRandomUpdates(narrowUpdates, balanced<BTree<int,int,4> >, "BTree with fanout 4");
+
+    if(failures == 0) {
+        cout << "\nAll checks passed" << endl;
+    }
+    return failures;
 }
@@ -3,22 +3,61 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
 #include <cstdlib>
 #include <utility>
+#include <tuple>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include "prefetch.h"
+#include "slab-arena.h"
+#include "frozen-index.h"
+
+/**
+ * The getters for parent/left/right used to be virtual so that derived
+ * nodes could return their own type. Derived nodes now just hide them with
+ * getters of the same name, so child access is resolved at compile time
+ * and nodes carry no vtable pointer. Build with -DBST_VIRTUAL_NODES to get
+ * the old virtual dispatch back (devirt-bench compares the two).
+ */
+#ifdef BST_VIRTUAL_NODES
+#define BST_NODE_VIRTUAL virtual
+#define BST_NODE_OVERRIDE override
+#else
+#define BST_NODE_VIRTUAL
+#define BST_NODE_OVERRIDE
+#endif
+
+/**
+ * Tag for the node constructors that build the item from the arguments of any
+ * std::pair constructor, which is what emplace is given.
+ */
+struct EmplaceItem {};
 
 /**
  * A templated class for a Node in a search tree.
- * The getters for parent/left/right are virtual so
- * that they can be overridden for future kinds of
- * search trees, such as Red Black trees, Splay trees,
- * and AVL trees.
+ * Trees that keep extra data per node, such as AVLTree
+ * and RedBlackTree, derive their own node from it and
+ * redefine the parent/left/right getters. SplayTree needs
+ * nothing extra and uses it as is.
  */
 template <typename Key, typename Value>
 class Node
 {
   public:
       Node(const Key& key, const Value& value, Node<Key, Value>* parent);
-      virtual ~Node();
+      template<typename KeyArg, typename... ValueArgs>
+      Node(Node<Key, Value>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs);
+      template<typename... Args>
+      Node(Node<Key, Value>* parent, EmplaceItem, Args&&... args);
+      // The pointers inside of a node are only used as references to existing nodes,
+      // which are freed by the BinarySearchTree. Defaulted in the class so a node whose
+      // item needs no destructor is trivially destructible (see clearNodes).
+      BST_NODE_VIRTUAL ~Node() = default;
 
       const std::pair<const Key, Value>& getItem() const;
       std::pair<const Key, Value>& getItem();
@@ -26,14 +65,15 @@ class Node
       const Value& getValue() const;
       Value& getValue();
 
-      virtual Node<Key, Value>* getParent() const;
-      virtual Node<Key, Value>* getLeft() const;
-      virtual Node<Key, Value>* getRight() const;
+      BST_NODE_VIRTUAL Node<Key, Value>* getParent() const;
+      BST_NODE_VIRTUAL Node<Key, Value>* getLeft() const;
+      BST_NODE_VIRTUAL Node<Key, Value>* getRight() const;
 
       void setParent(Node<Key, Value>* parent);
       void setLeft(Node<Key, Value>* left);
       void setRight(Node<Key, Value>* right);
       void setValue(const Value &value);
+      void setValue(Value&& value);
 
   protected:
       std::pair<const Key, Value> item_;
@@ -62,12 +102,32 @@ Node<Key, Value>::Node(const Key& key, const Value& value, Node<Key, Value>* par
 }
 
 /**
-* Destructor, which does not need to do anything since the pointers inside of a node
-* are only used as references to existing nodes. The nodes pointed to by parent/left/right
-* are freed by the BinarySearchTree.
+* Constructor that builds the key from key and the value from valueArgs in place,
+* so nothing is copied when the arguments are rvalues.
+*/
+template<typename Key, typename Value>
+template<typename KeyArg, typename... ValueArgs>
+Node<Key, Value>::Node(Node<Key, Value>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs) :
+    item_(std::piecewise_construct,
+          std::forward_as_tuple(std::forward<KeyArg>(key)),
+          std::forward_as_tuple(std::forward<ValueArgs>(valueArgs)...)),
+    parent_(parent),
+    left_(NULL),
+    right_(NULL)
+{
+
+}
+
+/**
+* Constructor that builds the item in place from args, as std::pair would.
 */
 template<typename Key, typename Value>
-Node<Key, Value>::~Node()
+template<typename... Args>
+Node<Key, Value>::Node(Node<Key, Value>* parent, EmplaceItem, Args&&... args) :
+    item_(std::forward<Args>(args)...),
+    parent_(parent),
+    left_(NULL),
+    right_(NULL)
 {
 
 }
@@ -118,7 +178,7 @@ Value& Node<Key, Value>::getValue()
 }
 
 /**
-* An implementation of the virtual function for retreiving the parent.
+* An implementation of the function for retreiving the parent.
 */
 template<typename Key, typename Value>
 Node<Key, Value>* Node<Key, Value>::getParent() const
@@ -127,21 +187,16 @@ Node<Key, Value>* Node<Key, Value>::getParent() const
 }
 
 /**
-* An implementation of the virtual function for retreiving the left child.
+* An implementation of the function for retreiving the left child.
 */
 template<typename Key, typename Value>
 Node<Key, Value>* Node<Key, Value>::getLeft() const
 {
-  if(left_ == NULL)
-  {
-    return NULL;
-  }
-
   return left_;
 }
 
 /**
-* An implementation of the virtual function for retreiving the right child.
+* An implementation of the function for retreiving the right child.
 */
 template<typename Key, typename Value>
 Node<Key, Value>* Node<Key, Value>::getRight() const
@@ -185,6 +240,15 @@ void Node<Key, Value>::setValue(const Value& value)
   item_.second = value;
 }
 
+/**
+* A setter for the value of a node that moves from value.
+*/
+template<typename Key, typename Value>
+void Node<Key, Value>::setValue(Value&& value)
+{
+  item_.second = std::move(value);
+}
+
 /*
   ---------------------------------------
   End implementations for the Node class.
@@ -193,29 +257,48 @@ void Node<Key, Value>::setValue(const Value& value)
 
 /**
 * A templated unbalanced binary search tree.
+* Nodes are allocated through the Alloc policy (see slab-arena.h), which
+* by default hands them out from contiguous slabs.
+* Value only has to be movable. The copying inserts are virtual, so they are
+* compiled for every Value, and for one that cannot be copied (such as a
+* std::unique_ptr) they throw std::logic_error; use emplace or the rvalue insert.
 */
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc = SlabArena>
 class BinarySearchTree
 {
   public:
       BinarySearchTree(); //TODO
       virtual ~BinarySearchTree(); //TODO
       virtual void insert(const std::pair<const Key, Value>& keyValuePair); //TODO
+      template<typename P>
+      typename std::enable_if<!std::is_lvalue_reference<P>::value &&
+                              std::is_constructible<std::pair<Key, Value>, P>::value>::type
+      insert(P&& keyValuePair);
       virtual void remove(const Key& key); //TODO
-      void clear(); //TODO
+      virtual void clear(); //TODO
       bool isBalanced() const; //TODO
+      bool equalPaths() const;
       void print() const;
       bool empty() const;
 
-      template<typename PPKey, typename PPValue>
-      friend void prettyPrintBST(BinarySearchTree<PPKey, PPValue> & tree);
+      template<typename PPKey, typename PPValue, typename PPAlloc>
+      friend void prettyPrintBST(BinarySearchTree<PPKey, PPValue, PPAlloc> & tree);
   public:
       /**
       * An internal iterator class for traversing the contents of the BST.
+      * It can step both ways, and stepping back from end() reaches the largest
+      * item, so it also works with std::reverse_iterator. Walking the whole
+      * tree costs amortized O(1) per step.
       */
       class iterator  // TODO
       {
         public:
+          typedef std::bidirectional_iterator_tag iterator_category;
+          typedef std::pair<const Key, Value> value_type;
+          typedef std::ptrdiff_t difference_type;
+          typedef std::pair<const Key, Value>* pointer;
+          typedef std::pair<const Key, Value>& reference;
+
           iterator();
 
           std::pair<const Key,Value>& operator*() const;
@@ -225,40 +308,178 @@ class BinarySearchTree
           bool operator!=(const iterator& rhs) const;
 
           iterator& operator++();
+          iterator operator++(int);
+          iterator& operator--();
+          iterator operator--(int);
 
         protected:
-          friend class BinarySearchTree<Key, Value>;
-          iterator(Node<Key,Value>* ptr);
+          friend class BinarySearchTree<Key, Value, Alloc>;
+          iterator(Node<Key,Value>* ptr, const BinarySearchTree<Key, Value, Alloc>* tree);
           Node<Key, Value> *current_;
+          const BinarySearchTree<Key, Value, Alloc>* tree_; // to step back from end()
       };
 
+      /**
+      * The same as iterator, but the items can only be read.
+      */
+      class const_iterator
+      {
+        public:
+          typedef std::bidirectional_iterator_tag iterator_category;
+          typedef std::pair<const Key, Value> value_type;
+          typedef std::ptrdiff_t difference_type;
+          typedef const std::pair<const Key, Value>* pointer;
+          typedef const std::pair<const Key, Value>& reference;
+
+          const_iterator();
+          const_iterator(const iterator& it);
+
+          const std::pair<const Key,Value>& operator*() const;
+          const std::pair<const Key,Value>* operator->() const;
+
+          bool operator==(const const_iterator& rhs) const;
+          bool operator!=(const const_iterator& rhs) const;
+
+          const_iterator& operator++();
+          const_iterator operator++(int);
+          const_iterator& operator--();
+          const_iterator operator--(int);
+
+        private:
+          friend class BinarySearchTree<Key, Value, Alloc>;
+          iterator it_;
+      };
+
+      typedef std::reverse_iterator<iterator> reverse_iterator;
+      typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  public:
+      /**
+      * The result of a balance check. height counts the nodes on the longest
+      * root to leaf path (0 for an empty tree), and offender is the first node
+      * in post order whose subtree heights differ by more than one, or NULL.
+      */
+      struct BalanceReport
+      {
+        bool balanced;
+        int height;
+        const Node<Key, Value>* offender;
+      };
+
+      BalanceReport balanceReport() const;
+
+      /**
+      * Remembers where a rangeScan stopped so the next call can carry on from there.
+      * A cursor must not be resumed after the tree has been modified.
+      */
+      class ScanCursor
+      {
+        public:
+          ScanCursor();
+          bool done() const;
+          void reset();
+
+        private:
+          friend class BinarySearchTree<Key, Value, Alloc>;
+          std::vector<Node<Key, Value>*> pending_; //nodes still to visit, smallest on top
+          bool started_;
+      };
+
+      std::size_t rangeScan(const Key& lo, const Key& hi, std::pair<Key, Value>* out,
+                            std::size_t max, ScanCursor& cursor) const;
+
+      template<typename Func>
+      void for_each(Func f) const;
+
+      FrozenIndex<Key, Value> freeze() const;
+      void freeze(FrozenIndex<Key, Value>& index) const;
+
   public:
     iterator begin() const;
     iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
     iterator find(const Key& key) const;
+    template<typename It>
+    void findMany(const std::vector<Key>& keys, std::vector<It>& results) const;
+    iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    std::pair<iterator, iterator> equal_range(const Key& key) const;
     Value& operator[](const Key& key);
     Value const & operator[](const Key& key) const;
 
+    // Move aware insertion. Unlike insert, emplace and try_emplace leave an
+    // existing value alone. Derived trees provide versions that build their own
+    // nodes in place, these go through moveInsert so they also work on a derived
+    // tree through a BinarySearchTree reference.
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value);
+    virtual iterator insert(iterator hint, const std::pair<const Key, Value>& keyValuePair);
+
   protected:
     // Mandatory helper functions
     Node<Key, Value>* internalFind(const Key& k) const; // TODO
+    Node<Key, Value>* boundNode(const Key& k, bool strict) const;
     Node<Key, Value> *getSmallestNode() const;  // TODO
+    Node<Key, Value> *getLargestNode() const;
     static Node<Key, Value>* predecessor(Node<Key, Value>* current); // TODO
     // Note:  static means these functions don't have a "this" pointer
     //        and instead just use the input argument.
 
     // Provided helper functions
-    virtual void printRoot (Node<Key, Value> *r) const;
+    void printRoot (Node<Key, Value> *r) const;
     virtual void nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2) ;
 
     // Add helper functions here
-    int getNodeHeight(const Node<Key, Value>* current) const;
-    void doClear(Node<Key, Value>* curr);
-    bool checkIsBalanced(Node<Key, Value>* temp) const;
+    template<typename NodeT>
+    void doClear(NodeT* curr, bool freeMemory = true);
     static Node<Key, Value>* successor(Node<Key, Value>* current);
+    static void pushLeftSpine(std::vector<Node<Key, Value>*>& stack, Node<Key, Value>* node);
+
+    virtual std::pair<iterator, bool> moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite);
+    virtual bool plainNodes() const;
+    template<typename NodeT>
+    NodeT* findSlot(const Key& key, NodeT*& parent, bool& goLeft) const;
+    template<typename NodeT, typename KeyArg, typename... ValueArgs>
+    std::pair<NodeT*, bool> emplaceNode(KeyArg&& key, ValueArgs&&... valueArgs);
+    template<typename NodeT, typename... Args>
+    std::pair<NodeT*, bool> emplaceItemNode(Args&&... args);
+    template<typename NodeT, typename KeyArg, typename... ValueArgs>
+    std::pair<NodeT*, bool> emplaceNodeHint(Node<Key, Value>* hint, KeyArg&& key, ValueArgs&&... valueArgs);
+    template<typename NodeT, typename... Args>
+    NodeT* attachNode(NodeT* parent, bool goLeft, Args&&... args);
+    template<typename NodeT>
+    void linkNode(NodeT* newNode, NodeT* parent, bool goLeft);
+    iterator makeIterator(Node<Key, Value>* node) const;
+    static Node<Key, Value>* hintNode(const iterator& it);
+    static Node<Key, Value>* hintNode(const const_iterator& it);
+    static std::pair<Key, Value> copyItem(const std::pair<const Key, Value>& item);
+    static std::pair<Key, Value> copyItem(const std::pair<const Key, Value>& item, std::true_type);
+    static std::pair<Key, Value> copyItem(const std::pair<const Key, Value>& item, std::false_type);
+
+    // Node allocation through the Alloc policy
+    template<typename NodeT, typename... Args>
+    NodeT* createNode(NodeT* parent, Args&&... args);
+    template<typename NodeT>
+    void destroyNode(NodeT* node);
+    template<typename NodeT>
+    void clearNodes(NodeT* root);
   protected:
     Node<Key, Value>* root_;
-    // You should not need other data members
+    mutable Node<Key, Value>* rightmost_;  // largest node, or NULL if not known yet
+    Alloc alloc_;
 };
 
 /*
@@ -268,22 +489,24 @@ Begin implementations for the BinarySearchTree::iterator class.
 */
 
 /**
-* Explicit constructor that initializes an iterator with a given node pointer.
+* Explicit constructor that initializes an iterator with a given node pointer
+* and the tree it belongs to.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::iterator::iterator(Node<Key,Value> *ptr) : current_(ptr) { } // TODO
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::iterator::iterator(Node<Key,Value> *ptr, const BinarySearchTree<Key, Value, Alloc>* tree) :
+    current_(ptr), tree_(tree) { } // TODO
 
 /**
 * A default constructor that initializes the iterator to NULL.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::iterator::iterator() : current_(NULL) {} // TODO
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::iterator::iterator() : current_(NULL), tree_(NULL) {} // TODO
 
 /**
 * Provides access to the item.
 */
-template<class Key, class Value>
-std::pair<const Key,Value>& BinarySearchTree<Key, Value>::iterator::operator*() const
+template<class Key, class Value, class Alloc>
+std::pair<const Key,Value>& BinarySearchTree<Key, Value, Alloc>::iterator::operator*() const
 {
   return current_->getItem();
 }
@@ -291,9 +514,9 @@ std::pair<const Key,Value>& BinarySearchTree<Key, Value>::iterator::operator*()
 /**
 * Provides access to the address of the item.
 */
-template<class Key, class Value>
+template<class Key, class Value, class Alloc>
 std::pair<const Key,Value> *
-BinarySearchTree<Key, Value>::iterator::operator->() const
+BinarySearchTree<Key, Value, Alloc>::iterator::operator->() const
 {
   return &(current_->getItem());
 }
@@ -302,15 +525,10 @@ BinarySearchTree<Key, Value>::iterator::operator->() const
 * Checks if 'this' iterator's internals have the same value
 * as 'rhs'
 */
-template<class Key, class Value>
-bool BinarySearchTree<Key, Value>::iterator::operator==(const BinarySearchTree<Key, Value>::iterator& rhs) const
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::iterator::operator==(const BinarySearchTree<Key, Value, Alloc>::iterator& rhs) const
 {
   //TODO
-  if(current_ == NULL)
-  {
-    return true;
-  }
-
   return this->current_ == rhs.current_;
 }
 
@@ -318,31 +536,69 @@ bool BinarySearchTree<Key, Value>::iterator::operator==(const BinarySearchTree<K
 * Checks if 'this' iterator's internals have a different value
 * as 'rhs'
 */
-template<class Key, class Value>
-bool BinarySearchTree<Key, Value>::iterator::operator!=(const BinarySearchTree<Key, Value>::iterator& rhs) const
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::iterator::operator!=(const BinarySearchTree<Key, Value, Alloc>::iterator& rhs) const
 {
   // TODO
-  if(current_ == NULL)
-  {
-    return false;
-  }
-
-  return !(this->current_ == rhs.current_);
+  return !(*this == rhs);
 }
 
 
 /**
 * Advances the iterator's location using an in-order sequencing
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator&
-BinarySearchTree<Key, Value>::iterator::operator++()
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator&
+BinarySearchTree<Key, Value, Alloc>::iterator::operator++()
 {
   // TODO
   current_ = successor(current_);
   return *this;
 }
 
+/**
+* Advances the iterator and returns where it was before.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::iterator::operator++(int)
+{
+  iterator old = *this;
+  ++(*this);
+  return old;
+}
+
+/**
+* Moves the iterator back to the previous item. From end() this is the
+* largest item, which the tree keeps cached.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator&
+BinarySearchTree<Key, Value, Alloc>::iterator::operator--()
+{
+  if(current_ == NULL)
+  {
+    current_ = tree_->getLargestNode();
+  }
+  else
+  {
+    current_ = predecessor(current_);
+  }
+  return *this;
+}
+
+/**
+* Moves the iterator back and returns where it was before.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::iterator::operator--(int)
+{
+  iterator old = *this;
+  --(*this);
+  return old;
+}
+
 
 /*
 -------------------------------------------------------------
@@ -350,6 +606,94 @@ End implementations for the BinarySearchTree::iterator class.
 -------------------------------------------------------------
 */
 
+/*
+--------------------------------------------------------------------
+Begin implementations for the BinarySearchTree::const_iterator class.
+--------------------------------------------------------------------
+*/
+
+/**
+* A default constructor that initializes the iterator to NULL.
+*/
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::const_iterator::const_iterator() : it_() {}
+
+/**
+* Converts an iterator into a read only one.
+*/
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::const_iterator::const_iterator(const iterator& it) : it_(it) {}
+
+/**
+* Provides read only access to the item.
+*/
+template<class Key, class Value, class Alloc>
+const std::pair<const Key,Value>& BinarySearchTree<Key, Value, Alloc>::const_iterator::operator*() const
+{
+  return *it_;
+}
+
+/**
+* Provides read only access to the address of the item.
+*/
+template<class Key, class Value, class Alloc>
+const std::pair<const Key,Value>* BinarySearchTree<Key, Value, Alloc>::const_iterator::operator->() const
+{
+  return it_.operator->();
+}
+
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::const_iterator::operator==(const const_iterator& rhs) const
+{
+  return it_ == rhs.it_;
+}
+
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::const_iterator::operator!=(const const_iterator& rhs) const
+{
+  return it_ != rhs.it_;
+}
+
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator&
+BinarySearchTree<Key, Value, Alloc>::const_iterator::operator++()
+{
+  ++it_;
+  return *this;
+}
+
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator
+BinarySearchTree<Key, Value, Alloc>::const_iterator::operator++(int)
+{
+  const_iterator old = *this;
+  ++it_;
+  return old;
+}
+
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator&
+BinarySearchTree<Key, Value, Alloc>::const_iterator::operator--()
+{
+  --it_;
+  return *this;
+}
+
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator
+BinarySearchTree<Key, Value, Alloc>::const_iterator::operator--(int)
+{
+  const_iterator old = *this;
+  --it_;
+  return old;
+}
+
+/*
+------------------------------------------------------------------
+End implementations for the BinarySearchTree::const_iterator class.
+------------------------------------------------------------------
+*/
+
 /*
 -----------------------------------------------------
 Begin implementations for the BinarySearchTree class.
@@ -359,11 +703,11 @@ Begin implementations for the BinarySearchTree class.
 /**
 * Default constructor for a BinarySearchTree, which sets the root to NULL.
 */
-template<class Key, class Value>
-BinarySearchTree<Key, Value>::BinarySearchTree() : root_(NULL) {}
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::BinarySearchTree() : root_(NULL), rightmost_(NULL) {}
 
-template<typename Key, typename Value>
-BinarySearchTree<Key, Value>::~BinarySearchTree()
+template<typename Key, typename Value, typename Alloc>
+BinarySearchTree<Key, Value, Alloc>::~BinarySearchTree()
 {
   // TODO
   clear();
@@ -372,14 +716,14 @@ BinarySearchTree<Key, Value>::~BinarySearchTree()
 /**
  * Returns true if tree is empty
 */
-template<class Key, class Value>
-bool BinarySearchTree<Key, Value>::empty() const
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::empty() const
 {
     return root_ == NULL;
 }
 
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::print() const
+template<typename Key, typename Value, typename Alloc>
+void BinarySearchTree<Key, Value, Alloc>::print() const
 {
     printRoot(root_);
     std::cout << "\n";
@@ -388,169 +732,767 @@ void BinarySearchTree<Key, Value>::print() const
 /**
 * Returns an iterator to the "smallest" item in the tree
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::begin() const
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::begin() const
 {
-    BinarySearchTree<Key, Value>::iterator begin(getSmallestNode());
+    BinarySearchTree<Key, Value, Alloc>::iterator begin(getSmallestNode(), this);
     return begin;
 }
 
 /**
 * Returns an iterator whose value means INVALID
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::end() const
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::end() const
 {
-    BinarySearchTree<Key, Value>::iterator end(NULL);
+    BinarySearchTree<Key, Value, Alloc>::iterator end(NULL, this);
     return end;
 }
 
 /**
-* Returns an iterator to the item with the given key, k
-* or the end iterator if k does not exist in the tree
+* Read only versions of begin() and end().
 */
-template<class Key, class Value>
-typename BinarySearchTree<Key, Value>::iterator
-BinarySearchTree<Key, Value>::find(const Key & k) const
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator
+BinarySearchTree<Key, Value, Alloc>::cbegin() const
 {
-    Node<Key, Value> *curr = internalFind(k);
-    BinarySearchTree<Key, Value>::iterator it(curr);
-    return it;
+    return const_iterator(begin());
+}
+
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_iterator
+BinarySearchTree<Key, Value, Alloc>::cend() const
+{
+    return const_iterator(end());
 }
 
 /**
- * @precondition The key exists in the map
- * Returns the value associated with the key
- */
-template<class Key, class Value>
-Value& BinarySearchTree<Key, Value>::operator[](const Key& key)
+* Returns a reverse iterator to the largest item, which the tree keeps cached.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::reverse_iterator
+BinarySearchTree<Key, Value, Alloc>::rbegin() const
 {
-  Node<Key, Value> *curr = internalFind(key);
-  if(curr == NULL) throw std::out_of_range("Invalid key");
-  return curr->getValue();
+    return reverse_iterator(end());
 }
-template<class Key, class Value>
-Value const & BinarySearchTree<Key, Value>::operator[](const Key& key) const
+
+/**
+* Returns the reverse iterator past the smallest item.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::reverse_iterator
+BinarySearchTree<Key, Value, Alloc>::rend() const
 {
-    Node<Key, Value> *curr = internalFind(key);
-    if(curr == NULL) throw std::out_of_range("Invalid key");
-    return curr->getValue();
+    return reverse_iterator(begin());
 }
 
 /**
-* An insert method to insert into a Binary Search Tree.
-* The tree will not remain balanced when inserting.
-* Recall: If key is already in the tree, you should 
-* overwrite the current value with the updated value.
+* Read only versions of rbegin() and rend().
 */
-template<class Key, class Value>
-void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &keyValuePair)
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_reverse_iterator
+BinarySearchTree<Key, Value, Alloc>::crbegin() const
 {
-  // TODO
-  if(root_ == NULL)
-  {
-    //allocate new memory for inserted pair
-    Node<Key, Value>* newNode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, NULL);
-    root_ = newNode;
-    root_->setLeft(NULL);
-    root_->setRight(NULL);
-    return;
-  }
+    return const_reverse_iterator(cend());
+}
 
-    Node<Key, Value>* temp = root_;
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::const_reverse_iterator
+BinarySearchTree<Key, Value, Alloc>::crend() const
+{
+    return const_reverse_iterator(cbegin());
+}
 
-    if((temp->getLeft() == NULL) || (temp->getRight() == NULL))
-    {
-      if((keyValuePair.first > temp->getKey()) && (temp->getRight() == NULL))
-      {
-        //allocate new memory for inserted pair
-        Node<Key, Value>* newNode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, temp);
-        
-        //set child
-        temp->setRight(newNode);
+/**
+* Returns an iterator to the item with the given key, k
+* or the end iterator if k does not exist in the tree
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::find(const Key & k) const
+{
+    Node<Key, Value> *curr = internalFind(k);
+    BinarySearchTree<Key, Value, Alloc>::iterator it(curr, this);
+    return it;
+}
 
-        //set parent
-        newNode->setParent(temp);
+/**
+* Looks up every key in keys and stores find(keys[i]) in results[i]. Lookups are
+* done in groups of FIND_GROUP that walk down the tree together, one level per
+* round, prefetching the next node of each walk. While one walk waits for its
+* node to arrive from memory the others make progress, so the cache misses of
+* a batch overlap instead of being paid one after the other. results may hold
+* iterators or const_iterators.
+*/
+template<class Key, class Value, class Alloc>
+template<typename It>
+void BinarySearchTree<Key, Value, Alloc>::findMany(const std::vector<Key>& keys, std::vector<It>& results) const
+{
+    const std::size_t FIND_GROUP = 16;
+    std::size_t count = keys.size();
+    results.assign(count, It(end()));
 
-        return;
+    for(std::size_t base = 0; base < count; base += FIND_GROUP)
+    {
+      std::size_t groupSize = std::min(FIND_GROUP, count - base);
+      Node<Key, Value>* walks[FIND_GROUP];
+      for(std::size_t i = 0; i < groupSize; ++i)
+      {
+        walks[i] = root_;
       }
 
-      else if((keyValuePair.first < temp->getKey()) && (temp->getLeft() == NULL))
+      //one step down for every unfinished walk per round
+      std::size_t active = (root_ == NULL ? 0 : groupSize);
+      while(active > 0)
       {
-        //allocate new memory for inserted pair
-        Node<Key, Value>* newNode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, temp);
-
-        //set child
-        temp->setLeft(newNode);
-
-        //set parent
-        newNode->setParent(temp);
-
-        return;
+        for(std::size_t i = 0; i < groupSize; ++i)
+        {
+          Node<Key, Value>* node = walks[i];
+          if(node == NULL)
+          {
+            continue;
+          }
+
+          const Key& k = keys[base + i];
+          if(k < node->getKey())
+          {
+            node = node->getLeft();
+          }
+          else if(node->getKey() < k)
+          {
+            node = node->getRight();
+          }
+          else
+          {
+            results[base + i] = It(iterator(node, this));
+            node = NULL;
+          }
+
+          //finished, either found or fell off the tree
+          if(node == NULL)
+          {
+            --active;
+          }
+          else
+          {
+            BST_PREFETCH(node);
+          }
+          walks[i] = node;
+        }
       }
     }
+}
 
-  //logic of where to insert
-  while(temp != NULL)
-  {
-    //equal to, and must replace value, everything else same
-    if(( keyValuePair.first == temp->getKey())) //&& (temp->getRight() == NULL) && (temp->getLeft() == NULL)
-    {
-      temp->setValue(keyValuePair.second);
-      break;
-    }
-    
-    //less than, and must traverse
-    else if((keyValuePair.first < temp->getKey()) && (temp->getLeft() != NULL))
-    {
-      temp = temp->getLeft();
-    }
+/**
+* Returns an iterator to the first item whose key is not less than k,
+* or the end iterator if there is none. O(height) like find.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::lower_bound(const Key & k) const
+{
+    return iterator(boundNode(k, false), this);
+}
 
-    //greater than, must traverse
-    else if((keyValuePair.first > temp->getKey()) && (temp->getRight() != NULL))
+/**
+* Returns an iterator to the first item whose key is greater than k,
+* or the end iterator if there is none.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::upper_bound(const Key & k) const
+{
+    return iterator(boundNode(k, true), this);
+}
+
+/**
+* Returns the range of items with key k as [lower_bound(k), upper_bound(k)).
+* Keys are unique, so it holds at most one item.
+*/
+template<class Key, class Value, class Alloc>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator,
+          typename BinarySearchTree<Key, Value, Alloc>::iterator>
+BinarySearchTree<Key, Value, Alloc>::equal_range(const Key & k) const
+{
+    Node<Key, Value>* first = boundNode(k, false);
+    Node<Key, Value>* last = first;
+    if(first != NULL && !(k < first->getKey()))
     {
-      temp = temp->getRight();
+      last = successor(first);
     }
+    return std::make_pair(iterator(first, this), iterator(last, this));
+}
 
-    //less than, able to allocate
-    else if((keyValuePair.first < temp->getKey()) && (temp->getLeft() == NULL))
-    {
-      //allocate new memory for inserted pair
-      Node<Key, Value>* newNode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, temp);
+/**
+* A new cursor, positioned before the first item of the range.
+*/
+template<class Key, class Value, class Alloc>
+BinarySearchTree<Key, Value, Alloc>::ScanCursor::ScanCursor() : started_(false)
+{
+
+}
 
-      //set child
-      temp->setLeft(newNode);
+/**
+* Returns true once a scan has handed out every item of its range.
+*/
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::ScanCursor::done() const
+{
+    return started_ && pending_.empty();
+}
+
+/**
+* Rewinds the cursor so it can be used for a new scan, keeping its stack memory.
+*/
+template<class Key, class Value, class Alloc>
+void BinarySearchTree<Key, Value, Alloc>::ScanCursor::reset()
+{
+    pending_.clear();
+    started_ = false;
+}
+
+/**
+* Copies up to max items with lo <= key < hi, in order, into out and returns how many
+* were written. The first call with a fresh cursor starts at lo, later calls with the
+* same cursor (and the same lo and hi) continue where the last one stopped, and 0 is
+* returned once the range is exhausted. The traversal keeps the nodes it still has to
+* visit on the cursor's stack instead of climbing through parents, so every node is
+* touched once, and nothing is allocated per item.
+*/
+template<class Key, class Value, class Alloc>
+std::size_t BinarySearchTree<Key, Value, Alloc>::rangeScan(const Key& lo, const Key& hi,
+    std::pair<Key, Value>* out, std::size_t max, ScanCursor& cursor) const
+{
+    std::vector<Node<Key, Value>*>& pending = cursor.pending_;
 
-      break;
+    //find the path to lo, remembering every node on it that is in range
+    if(!cursor.started_)
+    {
+      cursor.started_ = true;
+      Node<Key, Value>* temp = root_;
+      while(temp != NULL)
+      {
+        if(temp->getKey() < lo)
+        {
+          temp = temp->getRight();
+        }
+        else
+        {
+          pending.push_back(temp);
+          temp = temp->getLeft();
+        }
+      }
     }
 
-    //greater than, able to allocate
-    else
+    std::size_t count = 0;
+    while(count < max && !pending.empty())
     {
-      //allocate new memory for inserted pair
-      Node<Key, Value>* newNode = new Node<Key, Value>(keyValuePair.first, keyValuePair.second, temp);
+      Node<Key, Value>* node = pending.back();
+      pending.pop_back();
+
+      //past the end of the range, nothing left to hand out
+      if(!(node->getKey() < hi))
+      {
+        pending.clear();
+        break;
+      }
 
-      //set child
-      temp->setRight(newNode);
+      out[count].first = node->getKey();
+      out[count].second = node->getValue();
+      ++count;
 
-      break;
+      //everything right of node is bigger than it, so still at least lo
+      pushLeftSpine(pending, node->getRight());
     }
-  }
-    
 
-  
+    return count;
 }
 
-
 /**
-* A remove method to remove a specific key from a Binary Search Tree.
-* Recall: The writeup specifies that if a node has 2 children you
+* Returns a read only snapshot of the tree as a FrozenIndex, whose lookups need no
+* pointer chasing. Later changes to the tree do not show up in the snapshot.
+*/
+template<class Key, class Value, class Alloc>
+FrozenIndex<Key, Value> BinarySearchTree<Key, Value, Alloc>::freeze() const
+{
+  FrozenIndex<Key, Value> index;
+  freeze(index);
+  return index;
+}
+
+/**
+* Rebuilds index from the current contents of the tree in O(n). The items are
+* collected with for_each, which is much faster than walking the iterator.
+*/
+template<class Key, class Value, class Alloc>
+void BinarySearchTree<Key, Value, Alloc>::freeze(FrozenIndex<Key, Value>& index) const
+{
+  std::vector<std::pair<Key, Value> > items;
+  for_each([&items](const std::pair<const Key, Value>& item) { items.push_back(item); });
+  index.assign(std::move(items));
+}
+
+/**
+* Calls f on every item in key order. This is the fast way to do a full scan:
+* rather than running successor() for every step like the iterator, it keeps the
+* path to the next node on a stack, so every node is touched once, and the right
+* child of each node is prefetched when the node is pushed, so it is usually in
+* cache by the time the walk gets there.
+*/
+template<class Key, class Value, class Alloc>
+template<typename Func>
+void BinarySearchTree<Key, Value, Alloc>::for_each(Func f) const
+{
+    std::vector<Node<Key, Value>*> pending;
+    pending.reserve(64);
+    pushLeftSpine(pending, root_);
+
+    while(!pending.empty())
+    {
+      Node<Key, Value>* node = pending.back();
+      pending.pop_back();
+      f(node->getItem());
+      pushLeftSpine(pending, node->getRight());
+    }
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value, class Alloc>
+Value& BinarySearchTree<Key, Value, Alloc>::operator[](const Key& key)
+{
+  Node<Key, Value> *curr = internalFind(key);
+  if(curr == NULL) throw std::out_of_range("Invalid key");
+  return curr->getValue();
+}
+template<class Key, class Value, class Alloc>
+Value const & BinarySearchTree<Key, Value, Alloc>::operator[](const Key& key) const
+{
+    Node<Key, Value> *curr = internalFind(key);
+    if(curr == NULL) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+/**
+* An insert method to insert into a Binary Search Tree.
+* The tree will not remain balanced when inserting.
+* Recall: If key is already in the tree, you should 
+* overwrite the current value with the updated value.
+*/
+template<class Key, class Value, class Alloc>
+void BinarySearchTree<Key, Value, Alloc>::insert(const std::pair<const Key, Value> &keyValuePair)
+{
+  std::pair<Key, Value> keyValue = copyItem(keyValuePair);
+  moveInsert(keyValue, true);
+}
+
+/**
+* Inserts an rvalue pair, moving its key and value into the tree. Like the
+* copying insert it overwrites the value of an existing key.
+*/
+template<class Key, class Value, class Alloc>
+template<typename P>
+typename std::enable_if<!std::is_lvalue_reference<P>::value &&
+                        std::is_constructible<std::pair<Key, Value>, P>::value>::type
+BinarySearchTree<Key, Value, Alloc>::insert(P&& keyValuePair)
+{
+  std::pair<Key, Value> keyValue(std::forward<P>(keyValuePair));
+  moveInsert(keyValue, true);
+}
+
+/**
+* Builds a new node's item from args, like std::pair would, and links the node in
+* if its key is not in the tree yet; otherwise the node is destroyed again.
+* Returns an iterator to the item with that key and whether it was inserted.
+* A derived tree reached through a BinarySearchTree reference needs its own kind
+* of node, so there the item is built first and moved in by moveInsert.
+*/
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::emplace(Args&&... args)
+{
+  if(!plainNodes())
+  {
+    std::pair<Key, Value> keyValue(std::forward<Args>(args)...);
+    return moveInsert(keyValue, false);
+  }
+  std::pair<Node<Key, Value>*, bool> result = emplaceItemNode<Node<Key, Value> >(std::forward<Args>(args)...);
+  return std::make_pair(makeIterator(result.first), result.second);
+}
+
+/**
+* If key is not in the tree, inserts it with a value constructed in place
+* from args. Otherwise nothing happens and args are left untouched.
+*/
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::try_emplace(const Key& key, Args&&... args)
+{
+  if(plainNodes())
+  {
+    std::pair<Node<Key, Value>*, bool> result = emplaceNode<Node<Key, Value> >(key, std::forward<Args>(args)...);
+    return std::make_pair(makeIterator(result.first), result.second);
+  }
+
+  //looked up first so args are only used for a new item
+  Node<Key, Value>* curr = internalFind(key);
+  if(curr != NULL)
+  {
+    return std::make_pair(makeIterator(curr), false);
+  }
+  std::pair<Key, Value> keyValue(std::piecewise_construct, std::forward_as_tuple(key),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+  return moveInsert(keyValue, false);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::try_emplace(Key&& key, Args&&... args)
+{
+  if(plainNodes())
+  {
+    std::pair<Node<Key, Value>*, bool> result = emplaceNode<Node<Key, Value> >(std::move(key), std::forward<Args>(args)...);
+    return std::make_pair(makeIterator(result.first), result.second);
+  }
+
+  Node<Key, Value>* curr = internalFind(key);
+  if(curr != NULL)
+  {
+    return std::make_pair(makeIterator(curr), false);
+  }
+  std::pair<Key, Value> keyValue(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                 std::forward_as_tuple(std::forward<Args>(args)...));
+  return moveInsert(keyValue, false);
+}
+
+/**
+* Inserts key with the given value, or assigns the value to the existing key.
+* The second member of the result is true if a new item was inserted.
+*/
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::insert_or_assign(const Key& key, V&& value)
+{
+  std::pair<Key, Value> keyValue(key, std::forward<V>(value));
+  return moveInsert(keyValue, true);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::insert_or_assign(Key&& key, V&& value)
+{
+  std::pair<Key, Value> keyValue(std::move(key), std::forward<V>(value));
+  return moveInsert(keyValue, true);
+}
+
+/**
+* The virtual step behind the rvalue insert, emplace, try_emplace and
+* insert_or_assign, so derived trees can put the pair into their own kind of
+* node and rebalance. The pair is moved into a new node, or its value over the
+* existing one if overwrite is set. Returns the same as insert_or_assign.
+*/
+template<class Key, class Value, class Alloc>
+std::pair<typename BinarySearchTree<Key, Value, Alloc>::iterator, bool>
+BinarySearchTree<Key, Value, Alloc>::moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite)
+{
+  std::pair<Node<Key, Value>*, bool> result =
+    emplaceNode<Node<Key, Value> >(std::move(keyValuePair.first), std::move(keyValuePair.second));
+  if(!result.second && overwrite)
+  {
+    result.first->setValue(std::move(keyValuePair.second));
+  }
+  return std::make_pair(makeIterator(result.first), result.second);
+}
+
+/**
+* True if new items go into plain Nodes that need no fix up once linked in, as in
+* this class. Trees that override moveInsert return false.
+*/
+template<class Key, class Value, class Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::plainNodes() const
+{
+  return true;
+}
+
+/**
+* Returns the node with key, or NULL with parent and goLeft set to the spot
+* where a new leaf for key belongs.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT>
+NodeT* BinarySearchTree<Key, Value, Alloc>::findSlot(const Key& key, NodeT*& parent, bool& goLeft) const
+{
+  NodeT* temp = static_cast<NodeT*>(root_);
+  parent = NULL;
+  goLeft = false;
+
+  //logic of where to insert
+  while(temp != NULL)
+  {
+    if(key == temp->getKey())
+    {
+      return temp;
+    }
+
+    parent = temp;
+    goLeft = (key < temp->getKey());
+    temp = goLeft ? temp->getLeft() : temp->getRight();
+  }
+  return NULL;
+}
+
+/**
+* Finds the node for key, or creates a NodeT leaf for it in the right spot.
+* The arguments are only used (and possibly moved from) when a node is created.
+* Returns the node and true if it was created. No rebalancing is done here.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT, typename KeyArg, typename... ValueArgs>
+std::pair<NodeT*, bool> BinarySearchTree<Key, Value, Alloc>::emplaceNode(KeyArg&& key, ValueArgs&&... valueArgs)
+{
+  NodeT* parent;
+  bool goLeft;
+  NodeT* found = findSlot(key, parent, goLeft);
+  if(found != NULL)
+  {
+    return std::make_pair(found, false);
+  }
+
+  NodeT* newNode = attachNode(parent, goLeft, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+  return std::make_pair(newNode, true);
+}
+
+/**
+* The emplace of std::map: builds a NodeT with its item made from args, as std::pair
+* would, and then links it in as a new leaf, or destroys it if its key is already
+* in the tree. Unlike emplaceNode the key is not known before the item is built.
+* Returns the same as emplaceNode.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT, typename... Args>
+std::pair<NodeT*, bool> BinarySearchTree<Key, Value, Alloc>::emplaceItemNode(Args&&... args)
+{
+  NodeT* newNode = createNode<NodeT>(NULL, EmplaceItem(), std::forward<Args>(args)...);
+
+  NodeT* parent;
+  bool goLeft;
+  NodeT* found = findSlot(newNode->getKey(), parent, goLeft);
+  if(found != NULL)
+  {
+    destroyNode(newNode);
+    return std::make_pair(found, false);
+  }
+
+  newNode->setParent(parent);
+  linkNode(newNode, parent, goLeft);
+  return std::make_pair(newNode, true);
+}
+
+/**
+* Like emplaceNode, but first tries to place key right before or right after hint
+* (or after the largest node if hint is NULL, the end iterator). When key belongs
+* there the new leaf is linked without descending from the root, otherwise this
+* falls back to emplaceNode.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT, typename KeyArg, typename... ValueArgs>
+std::pair<NodeT*, bool> BinarySearchTree<Key, Value, Alloc>::emplaceNodeHint(Node<Key, Value>* hint, KeyArg&& key, ValueArgs&&... valueArgs)
+{
+  Node<Key, Value>* before = NULL;
+  Node<Key, Value>* after = hint;
+
+  if(hint == NULL)
+  {
+    //appending after the largest key
+    before = getLargestNode();
+    if(before != NULL && before->getKey() < key)
+    {
+      NodeT* newNode = attachNode(static_cast<NodeT*>(before), false, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+      return std::make_pair(newNode, true);
+    }
+  }
+  else if(key < hint->getKey())
+  {
+    //key goes between hint's predecessor and hint
+    before = predecessor(hint);
+    if(before == NULL || before->getKey() < key)
+    {
+      NodeT* newNode = NULL;
+      if(after->getLeft() == NULL)
+      {
+        newNode = attachNode(static_cast<NodeT*>(after), true, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+      }
+      //otherwise the predecessor is the bottom of hint's left subtree
+      else
+      {
+        newNode = attachNode(static_cast<NodeT*>(before), false, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+      }
+      return std::make_pair(newNode, true);
+    }
+  }
+  else if(hint->getKey() < key)
+  {
+    //key goes right after hint, which is how an iterator to the last insert is used.
+    //For ascending keys that is the largest node, and successor() would climb its
+    //whole right spine to find nothing, so the cached rightmost_ is asked first
+    before = hint;
+    after = (hint == getLargestNode()) ? NULL : successor(hint);
+    if(after == NULL || key < after->getKey())
+    {
+      NodeT* newNode = NULL;
+      if(before->getRight() == NULL)
+      {
+        newNode = attachNode(static_cast<NodeT*>(before), false, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+      }
+      //otherwise the successor is the bottom of hint's right subtree
+      else
+      {
+        newNode = attachNode(static_cast<NodeT*>(after), true, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+      }
+      return std::make_pair(newNode, true);
+    }
+  }
+  else
+  {
+    return std::make_pair(static_cast<NodeT*>(hint), false);
+  }
+
+  //hint was wrong, insert normally
+  return emplaceNode<NodeT>(std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...);
+}
+
+/**
+* Creates a new leaf, with the key from the first of args and the value from the
+* rest, and links it in as the left or right child of parent, or as the root if
+* parent is NULL.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT, typename... Args>
+NodeT* BinarySearchTree<Key, Value, Alloc>::attachNode(NodeT* parent, bool goLeft, Args&&... args)
+{
+  //allocate new memory for inserted pair
+  NodeT* newNode = createNode(parent, std::piecewise_construct, std::forward<Args>(args)...);
+  linkNode(newNode, parent, goLeft);
+  return newNode;
+}
+
+/**
+* Links newNode in as a leaf below parent, see attachNode. newNode's parent
+* pointer must already be set.
+*/
+template<class Key, class Value, class Alloc>
+template<typename NodeT>
+void BinarySearchTree<Key, Value, Alloc>::linkNode(NodeT* newNode, NodeT* parent, bool goLeft)
+{
+  if(parent == NULL)
+  {
+    root_ = newNode;
+    rightmost_ = newNode;
+  }
+  else if(goLeft)
+  {
+    parent->setLeft(newNode);
+  }
+  else
+  {
+    parent->setRight(newNode);
+
+    //a right child of the largest node is the new largest node
+    if(parent == rightmost_)
+    {
+      rightmost_ = newNode;
+    }
+  }
+}
+
+/**
+* Inserts the pair as close as possible to the position just before hint, like
+* std::map. If the key belongs right next to hint (or hint is end() and the key
+* is larger than every other key) no search from the root is needed, so feeding
+* keys in ascending order with end() or the last returned iterator as the hint
+* takes amortized O(1) per key.
+* As with insert, an existing key has its value overwritten. Returns an iterator
+* to the item with the key.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::insert(iterator hint, const std::pair<const Key, Value>& keyValuePair)
+{
+  std::pair<Key, Value> keyValue = copyItem(keyValuePair);
+  std::pair<Node<Key, Value>*, bool> result =
+    emplaceNodeHint<Node<Key, Value> >(hint.current_, std::move(keyValue.first), std::move(keyValue.second));
+  if(!result.second)
+  {
+    result.first->setValue(std::move(keyValue.second));
+  }
+  return makeIterator(result.first);
+}
+
+/**
+* Lets derived trees get at the node behind an iterator.
+*/
+template<class Key, class Value, class Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::hintNode(const iterator& it)
+{
+  return it.current_;
+}
+
+template<class Key, class Value, class Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::hintNode(const const_iterator& it)
+{
+  return it.it_.current_;
+}
+
+/**
+* Copies item for the copying inserts. Those are virtual and so compiled even when
+* Value cannot be copied, which is why the copy is picked by overload: for such a
+* Value only the throwing version below is compiled.
+*/
+template<class Key, class Value, class Alloc>
+std::pair<Key, Value> BinarySearchTree<Key, Value, Alloc>::copyItem(const std::pair<const Key, Value>& item)
+{
+  return copyItem(item, std::integral_constant<bool, std::is_copy_constructible<Value>::value>());
+}
+
+template<class Key, class Value, class Alloc>
+std::pair<Key, Value> BinarySearchTree<Key, Value, Alloc>::copyItem(const std::pair<const Key, Value>& item, std::true_type)
+{
+  return std::pair<Key, Value>(item.first, item.second);
+}
+
+template<class Key, class Value, class Alloc>
+std::pair<Key, Value> BinarySearchTree<Key, Value, Alloc>::copyItem(const std::pair<const Key, Value>&, std::false_type)
+{
+  throw std::logic_error("Value cannot be copied, use emplace or insert an rvalue");
+}
+
+/**
+* Lets derived trees build iterators, whose node constructor is protected.
+*/
+template<class Key, class Value, class Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::iterator
+BinarySearchTree<Key, Value, Alloc>::makeIterator(Node<Key, Value>* node) const
+{
+  return iterator(node, this);
+}
+
+
+/**
+* A remove method to remove a specific key from a Binary Search Tree.
+* Recall: The writeup specifies that if a node has 2 children you
 * should swap with the predecessor and then remove.
 */
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::remove(const Key& key)
+template<typename Key, typename Value, typename Alloc>
+void BinarySearchTree<Key, Value, Alloc>::remove(const Key& key)
 {
   //tree is empty
   if(root_ == NULL)
@@ -568,6 +1510,12 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     return;
   }
 
+  //the largest node is found again lazily
+  if(curr == rightmost_)
+  {
+    rightmost_ = NULL;
+  }
+
   //2 child case
   if((curr->getLeft() != NULL) && (curr->getRight() != NULL))
   {
@@ -591,7 +1539,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
   if((isRoot) && (right == NULL) && (left == NULL))
   {
     //curr = NULL;
-    delete curr;
+    destroyNode(curr);
     root_ = NULL;
     return;
   }
@@ -657,7 +1605,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     }
 
     //curr = NULL;
-    delete curr;
+    destroyNode(curr);
   }
 
   //0 child case
@@ -676,7 +1624,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     }
 
     //curr = NULL;
-    delete curr;
+    destroyNode(curr);
     return;
   }
 
@@ -685,10 +1633,9 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
 
 
 
-template<class Key, class Value>
-Node<Key, Value>* BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* current)
+template<class Key, class Value, class Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::predecessor(Node<Key, Value>* current)
 {
-  // TODO
   if(current == NULL)
   {
     return NULL;
@@ -705,53 +1652,26 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* cu
     return suc;
   }
 
-  else
+  //climb until we come up from a right child
+  suc = current->getParent();
+  while((suc != NULL) && (suc->getLeft() == current))
   {
-    if(current->getParent() == NULL)
-    {
-      return NULL;;
-    }
-
-    suc = current->getParent();
-
-    if((suc != NULL) && (suc->getRight() != NULL))
-    { 
-      Node<Key, Value>* temp = suc->getParent()->getRight();
-
-      if((suc->getRight() != NULL)&&(temp->getKey() == current->getKey()))
-      {
-        return suc;
-      }
-
-      else
-      {
-        return NULL;
-      }
-    }
-
-    else
-    {
-      suc = suc->getParent();
-      while(suc->getRight() != current)
-      {
-        suc = suc->getParent();
-        if(suc->getParent() == NULL)
-        {
-          return NULL;
-        }
-      }
-      return suc;
-    }
+    current = suc;
+    suc = suc->getParent();
   }
 
-  return NULL;
+  return suc;
 }
 
 //my helper function
-template<class Key, class Value>
-Node<Key, Value>* BinarySearchTree<Key, Value>::successor(Node<Key, Value>* current)
+template<class Key, class Value, class Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::successor(Node<Key, Value>* current)
 {
-  // TODO
+  if(current == NULL)
+  {
+    return NULL;
+  }
+
   Node<Key, Value>* suc = NULL;
   if(current->getRight() != NULL)
   {
@@ -760,26 +1680,15 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::successor(Node<Key, Value>* curr
     {
       suc = suc->getLeft();
     }
+    return suc;
   }
 
-  else
+  //climb until we come up from a left child
+  suc = current->getParent();
+  while((suc != NULL) && (suc->getRight() == current))
   {
-    if(suc == NULL)
-    {
-      return NULL;
-    }
-
+    current = suc;
     suc = suc->getParent();
-
-    while(suc != NULL)
-    {
-      if(suc == suc->getParent()->getLeft())
-      {
-        break;
-      }
-
-      suc = suc->getParent();
-    }
   }
 
   return suc;
@@ -788,39 +1697,122 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::successor(Node<Key, Value>* curr
 * A method to remove all contents of the tree and
 * reset the values in the tree for use again.
 */
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::clear()
+template<typename Key, typename Value, typename Alloc>
+void BinarySearchTree<Key, Value, Alloc>::clear()
 {
-  //TODO
-  doClear(this->root_);
+  clearNodes(this->root_);
   root_ = NULL;
 }
 
-//my helper function
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::doClear(Node<Key, Value>* curr)
+/**
+* Destroys every node below root and hands their memory back to the allocator.
+* When the allocator can drop all of its memory at once, the nodes are only
+* destructed, and when the nodes need no destructor either (nothing in the key,
+* value or node extras has one) the tree is not walked at all.
+*/
+template<typename Key, typename Value, typename Alloc>
+template<typename NodeT>
+void BinarySearchTree<Key, Value, Alloc>::clearNodes(NodeT* root)
+{
+  bool trivial = std::is_trivially_destructible<NodeT>::value;
+  bool bulk = alloc_.canRelease();
+  rightmost_ = NULL;
+
+  if(!(trivial && bulk))
+  {
+    doClear(root, !bulk);
+  }
+
+  if(bulk)
+  {
+    alloc_.release();
+  }
+}
+
+/**
+* Destroys the subtree at curr without recursion, so even a tree as tall as it
+* has nodes can be torn down. It repeatedly walks down to a leaf, destroys it and
+* steps back up through the parent pointer, which needs no extra memory. If
+* freeMemory is false the nodes are destructed but not given back to the allocator.
+*/
+template<typename Key, typename Value, typename Alloc>
+template<typename NodeT>
+void BinarySearchTree<Key, Value, Alloc>::doClear(NodeT* curr, bool freeMemory)
 {
-  //post order delete?
-  if( curr == NULL)
+  if(curr == NULL)
   {
     return;
   }
-  
-  else
-  {  
+
+  NodeT* stop = curr->getParent();
+  while(curr != stop)
+  {
     if(curr->getLeft() != NULL)
     {
-      doClear(curr->getLeft());
+      curr = curr->getLeft();
     }
-
-    if(curr->getRight() != NULL)
+    else if(curr->getRight() != NULL)
     {
-      doClear(curr->getRight());
+      curr = curr->getRight();
+    }
+    else
+    {
+      //curr is a leaf, unhook it from its parent and destroy it
+      NodeT* parent = curr->getParent();
+      if(parent != NULL)
+      {
+        if(parent->getLeft() == curr)
+        {
+          parent->setLeft(NULL);
+        }
+        else
+        {
+          parent->setRight(NULL);
+        }
+      }
+
+      if(freeMemory)
+      {
+        destroyNode(curr);
+      }
+      else
+      {
+        curr->~NodeT();
+      }
+      curr = parent;
     }
-    delete curr;
   }
+}
 
-  
+/**
+* Allocates a node of type NodeT from the tree's allocator and constructs it in
+* place with NodeT(parent, args...).
+*/
+template<typename Key, typename Value, typename Alloc>
+template<typename NodeT, typename... Args>
+NodeT* BinarySearchTree<Key, Value, Alloc>::createNode(NodeT* parent, Args&&... args)
+{
+  void* mem = alloc_.allocate(sizeof(NodeT));
+  try
+  {
+    return new (mem) NodeT(parent, std::forward<Args>(args)...);
+  }
+  catch(...)
+  {
+    alloc_.deallocate(mem, sizeof(NodeT));
+    throw;
+  }
+}
+
+/**
+* Destroys a node created by createNode and returns its memory to the allocator.
+*/
+template<typename Key, typename Value, typename Alloc>
+template<typename NodeT>
+void BinarySearchTree<Key, Value, Alloc>::destroyNode(NodeT* node)
+{
+  node->~NodeT();
+  alloc_.deallocate(node, sizeof(NodeT));
 }
 
 
@@ -829,12 +1821,11 @@ void BinarySearchTree<Key, Value>::doClear(Node<Key, Value>* curr)
 /**
 * A helper function to find the smallest node in the tree.
 */
-template<typename Key, typename Value>
-Node<Key, Value>* BinarySearchTree<Key, Value>::getSmallestNode() const
+template<typename Key, typename Value, typename Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::getSmallestNode() const
 {
-  // TODO
-  //root has no smaller children, return root
-  if(root_->getLeft() == NULL)
+  //empty tree or root has no smaller children, return root
+  if(root_ == NULL || root_->getLeft() == NULL)
   {
     return root_;
   }
@@ -848,13 +1839,33 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::getSmallestNode() const
   return temp;
 }
 
+/**
+* A helper function to find the largest node in the tree. The answer is cached
+* in rightmost_ so appending in ascending order does not walk the right spine.
+*/
+template<typename Key, typename Value, typename Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::getLargestNode() const
+{
+  if(rightmost_ == NULL && root_ != NULL)
+  {
+    Node<Key, Value>* temp = root_;
+    while(temp->getRight() != NULL)
+    {
+      temp = temp->getRight();
+    }
+    rightmost_ = temp;
+  }
+
+  return rightmost_;
+}
+
 /**
 * Helper function to find a node with given key, k and
 * return a pointer to it or NULL if no item with that key
 * exists
 */
-template<typename Key, typename Value>
-Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) const
+template<typename Key, typename Value, typename Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::internalFind(const Key& key) const
 {
   // TODO
   Node<Key, Value>* temp = root_;
@@ -885,85 +1896,177 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) con
 }
 
 /**
- * Return true iff the BST is balanced.
- */
-template<typename Key, typename Value>
-bool BinarySearchTree<Key, Value>::isBalanced() const
+* Finds the smallest node whose key is greater than k (strict) or not less
+* than k (not strict) in a single walk down the tree, or NULL if there is none.
+* Only uses operator< on the keys.
+*/
+template<typename Key, typename Value, typename Alloc>
+Node<Key, Value>* BinarySearchTree<Key, Value, Alloc>::boundNode(const Key& k, bool strict) const
 {
-    // TODO
-    if(root_ == NULL)
+  Node<Key, Value>* temp = root_;
+  Node<Key, Value>* best = NULL;
+
+  while(temp != NULL)
+  {
+    bool goLeft = strict ? (k < temp->getKey()) : !(temp->getKey() < k);
+
+    //temp qualifies, but a smaller one may be on the left
+    if(goLeft)
     {
-      return true;
+      best = temp;
+      temp = temp->getLeft();
     }
-    
-    if(checkIsBalanced(root_) == true)
+    else
     {
-      return true;
+      temp = temp->getRight();
     }
+  }
 
-    return false;
+  return best;
 }
 
-//my helper function
-template<typename Key, typename Value>
-bool BinarySearchTree<Key, Value>::checkIsBalanced(Node<Key, Value>* temp) const
+//my helper function, the right children are visited next so start loading them
+template<typename Key, typename Value, typename Alloc>
+void BinarySearchTree<Key, Value, Alloc>::pushLeftSpine(std::vector<Node<Key, Value>*>& stack, Node<Key, Value>* node)
 {
-    // TODO
-    if(temp == NULL)
-    {
-      return true; //i do not think this is correct, will need to update later
-    }
+  while(node != NULL)
+  {
+    BST_PREFETCH(node->getRight());
+    stack.push_back(node);
+    node = node->getLeft();
+  }
+}
 
-    //get height of children
-    int right = 0;
-    int left = 0;
+/**
+ * Return true iff the BST is balanced.
+ */
+template<typename Key, typename Value, typename Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::isBalanced() const
+{
+    return balanceReport().balanced;
+}
 
-    if(temp->getLeft() != NULL)
-    {
-      left = getNodeHeight(temp->getLeft());
-    }
-    if(temp->getRight() != NULL)
+/**
+ * Checks every node in a single post order pass, so it runs in O(n). The pass
+ * keeps its own stack on the heap, so degenerate trees cannot overflow the call stack.
+ * AVLTree shares root_, so this checks AVL trees as well.
+ */
+template<typename Key, typename Value, typename Alloc>
+typename BinarySearchTree<Key, Value, Alloc>::BalanceReport
+BinarySearchTree<Key, Value, Alloc>::balanceReport() const
+{
+    BalanceReport report;
+    report.balanced = true;
+    report.height = 0;
+    report.offender = NULL;
+
+    //each frame is a node whose children are still being measured
+    struct Frame
     {
-      right = getNodeHeight(temp->getRight());
-    }
+      const Node<Key, Value>* node;
+      int leftHeight;
+      bool leftDone;
+    };
 
-    //if balance if any child is greater than 1, not balanced
-    if(left + right > 1 || left + right < -1)
+    std::vector<Frame> stack;
+    const Node<Key, Value>* curr = root_;
+    int last = 0; //height of the subtree that was just finished
+
+    while(true)
     {
-      return false;
+      //walk down to the leftmost node of curr's subtree
+      while(curr != NULL)
+      {
+        Frame frame = { curr, 0, false };
+        stack.push_back(frame);
+        curr = curr->getLeft();
+      }
+      last = 0;
+
+      //finish every frame whose right subtree is done as well
+      while(!stack.empty() && stack.back().leftDone)
+      {
+        Frame& top = stack.back();
+        int diff = top.leftHeight - last;
+        if((diff > 1 || diff < -1) && report.balanced)
+        {
+          report.balanced = false;
+          report.offender = top.node;
+        }
+        last = 1 + std::max(top.leftHeight, last);
+        stack.pop_back();
+      }
+
+      if(stack.empty())
+      {
+        break;
+      }
+
+      //left subtree is done, now measure the right one
+      Frame& top = stack.back();
+      top.leftHeight = last;
+      top.leftDone = true;
+      curr = top.node->getRight();
     }
 
-    //recursively check
-    checkIsBalanced(temp->getLeft());
-    checkIsBalanced(temp->getRight());
+    report.height = last;
+    return report;
 }
 
-//my helper function
-template<typename Key, typename Value>
-int BinarySearchTree<Key, Value>::getNodeHeight(const Node<Key, Value>* current) const
+/**
+ * Return true iff every leaf is at the same depth, like equalPaths in equal-paths.h.
+ * The tree is walked through the parent pointers while keeping track of the depth,
+ * so it needs no extra memory, and it stops at the first leaf at a different depth.
+ */
+template<typename Key, typename Value, typename Alloc>
+bool BinarySearchTree<Key, Value, Alloc>::equalPaths() const
 {
-    // Base case
-    if(current == NULL)
-    {
-      return -1;
-    }
-       
-    // Initialize distance as -1
-    int dist = -1;
-  
-    if((dist = getNodeHeight(current->getLeft() ) >= 0) || (dist = getNodeHeight(current->getRight() ) >= 0))
+    const Node<Key, Value>* curr = root_;
+    const Node<Key, Value>* prev = NULL;
+    int depth = 0;
+    int leafDepth = -1;
+
+    while(curr != NULL)
     {
-      // Return depth of the node
-      return dist + 1;
+      const Node<Key, Value>* next;
+
+      //coming down from the parent, go left if possible
+      if(prev == curr->getParent() && curr->getLeft() != NULL)
+      {
+        next = curr->getLeft();
+      }
+      //done with the left side (or there is none), go right if possible
+      else if(prev != curr->getRight() && curr->getRight() != NULL)
+      {
+        next = curr->getRight();
+      }
+      //both sides done, go back up
+      else
+      {
+        if(curr->getLeft() == NULL && curr->getRight() == NULL)
+        {
+          if(leafDepth == -1)
+          {
+            leafDepth = depth;
+          }
+          else if(depth != leafDepth)
+          {
+            return false;
+          }
+        }
+        next = curr->getParent();
+      }
+
+      depth += (next == curr->getParent() ? -1 : 1);
+      prev = curr;
+      curr = next;
     }
-  
-    return dist;
 
+    return true;
 }
 
-
-template<typename Key, typename Value>
-void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2)
+template<typename Key, typename Value, typename Alloc>
+void BinarySearchTree<Key, Value, Alloc>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2)
 {
     if((n1 == n2) || (n1 == NULL) || (n2 == NULL) ) {
         return;
@@ -0,0 +1,1200 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <iostream>
+#include <stdexcept>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "prefetch.h"
+#include "simd-search.h"
+
+/**
+* A B+ tree with the same interface as BinarySearchTree, so code can switch between
+* them by changing the type name. Every node holds up to Fanout keys (16 to 64 work
+* well), so a lookup visits about log_Fanout(n) nodes instead of log_2(n) and most of
+* them are already in cache. Inner nodes only hold separator keys and child pointers;
+* the items live in the leaves, which are linked both ways for iteration.
+* Leaves keep a copy of their keys in a dense array next to the items, so searching
+* a leaf only reads key cache lines. Keys must be default constructible and
+* assignable. Inserting or removing an item invalidates all iterators.
+*/
+template <typename Key, typename Value, int Fanout = 64>
+class BTree
+{
+  static_assert(Fanout >= 4, "BTree needs a fanout of at least 4");
+
+  public:
+    BTree();
+    ~BTree();
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool isBalanced() const;
+    void print() const;
+    bool empty() const;
+    std::size_t size() const;
+
+  protected:
+    struct Leaf;
+
+  public:
+    /**
+    * An iterator over the leaves. It holds a leaf and a position in it, and
+    * stepping back from end() reaches the largest item.
+    */
+    class iterator
+    {
+      public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::pair<const Key, Value> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::pair<const Key, Value>* pointer;
+        typedef std::pair<const Key, Value>& reference;
+
+        iterator();
+
+        std::pair<const Key,Value>& operator*() const;
+        std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+        iterator operator++(int);
+        iterator& operator--();
+        iterator operator--(int);
+
+      protected:
+        friend class BTree<Key, Value, Fanout>;
+        iterator(Leaf* leaf, int index, const BTree<Key, Value, Fanout>* tree);
+        Leaf* leaf_;
+        int index_;
+        const BTree<Key, Value, Fanout>* tree_; // to step back from end()
+    };
+
+    /**
+    * The same as iterator, but the items can only be read.
+    */
+    class const_iterator
+    {
+      public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::pair<const Key, Value> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::pair<const Key, Value>* pointer;
+        typedef const std::pair<const Key, Value>& reference;
+
+        const_iterator();
+        const_iterator(const iterator& it);
+
+        const std::pair<const Key,Value>& operator*() const;
+        const std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const const_iterator& rhs) const;
+        bool operator!=(const const_iterator& rhs) const;
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+
+      private:
+        iterator it_;
+    };
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  public:
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+    iterator find(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+    template<typename Func>
+    void for_each(Func f) const;
+
+  protected:
+    typedef std::pair<const Key, Value> Item;
+
+    // The part both kinds of node start with, count is the number of keys.
+    struct NodeBase
+    {
+      int count;
+      bool leaf;
+    };
+
+    // Child i holds the keys from keys[i - 1] up to but not including keys[i].
+    struct Inner : NodeBase
+    {
+      Key keys[Fanout];
+      NodeBase* children[Fanout + 1];
+    };
+
+    // Items are constructed in place in slots, keys[i] is a copy of item(i).first.
+    struct Leaf : NodeBase
+    {
+      Key keys[Fanout];
+      typename std::aligned_storage<sizeof(Item), alignof(Item)>::type slots[Fanout];
+      Leaf* prev;
+      Leaf* next;
+
+      Item& item(int i) { return *reinterpret_cast<Item*>(&slots[i]); }
+    };
+
+    // One step on the way down: an inner node and the index of the child taken.
+    struct PathStep
+    {
+      Inner* node;
+      int child;
+    };
+
+    // Nodes other than the root never get less full than this
+    static const int MIN_LEAF = Fanout / 2;
+    static const int MIN_INNER = (Fanout - 1) / 2;
+    // Every inner node has at least two children, so this is never reached
+    static const int MAX_DEPTH = 64;
+
+    // Add helper functions here
+    static int lowerIndex(const Key* keys, int count, const Key& key);
+    static int upperIndex(const Key* keys, int count, const Key& key);
+    static void prefetchKeys(const Key* keys, int count);
+    Leaf* findLeaf(const Key& key, PathStep* path, int& depth) const;
+    iterator leafIterator(Leaf* leaf, int index) const;
+    static Leaf* newLeaf();
+    static Inner* newInner();
+    static void moveItem(Leaf* from, int i, Leaf* to, int j);
+    static void insertChild(Inner* inner, int pos, const Key& key, NodeBase* child);
+    static void removeChild(Inner* inner, int pos);
+    void insertItem(Leaf* leaf, int pos, const std::pair<const Key, Value>& keyValuePair);
+    Leaf* splitLeaf(Leaf* leaf);
+    void insertSeparator(PathStep* path, int depth, Key key, NodeBase* right);
+    bool fixUnderflow(Inner* parent, int child);
+    void mergeLeaves(Leaf* left, Leaf* right);
+    static void mergeInners(Inner* parent, int sep);
+    void doClear(NodeBase* node);
+    bool checkNode(const NodeBase* node, int depth, int& leafDepth, const Key* lo, const Key* hi) const;
+
+    // Trees own their nodes, so they cannot be copied.
+    BTree(const BTree& other);
+    BTree& operator=(const BTree& other);
+
+  protected:
+    NodeBase* root_;
+    Leaf* head_;  // smallest leaf
+    Leaf* tail_;  // largest leaf
+    std::size_t size_;
+};
+
+/*
+  ---------------------------------------------
+  Begin implementations for the BTree::iterator class.
+  ---------------------------------------------
+*/
+
+/**
+* Explicit constructor that initializes an iterator with a leaf, a position in it
+* and the tree it belongs to.
+*/
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::iterator::iterator(Leaf* leaf, int index, const BTree<Key, Value, Fanout>* tree) :
+    leaf_(leaf), index_(index), tree_(tree) { }
+
+/**
+* A default constructor that initializes the iterator to NULL.
+*/
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::iterator::iterator() : leaf_(NULL), index_(0), tree_(NULL) { }
+
+/**
+* Provides access to the item.
+*/
+template<typename Key, typename Value, int Fanout>
+std::pair<const Key, Value>& BTree<Key, Value, Fanout>::iterator::operator*() const
+{
+  return leaf_->item(index_);
+}
+
+/**
+* Provides access to the address of the item.
+*/
+template<typename Key, typename Value, int Fanout>
+std::pair<const Key, Value>* BTree<Key, Value, Fanout>::iterator::operator->() const
+{
+  return &(leaf_->item(index_));
+}
+
+/**
+* Checks if 'this' iterator's internals have the same value
+* as 'rhs'
+*/
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::iterator::operator==(const iterator& rhs) const
+{
+  return leaf_ == rhs.leaf_ && index_ == rhs.index_;
+}
+
+/**
+* Checks if 'this' iterator's internals have a different value
+* as 'rhs'
+*/
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::iterator::operator!=(const iterator& rhs) const
+{
+  return !(*this == rhs);
+}
+
+/**
+* Advances the iterator's location, moving on to the next leaf at the end of one.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator&
+BTree<Key, Value, Fanout>::iterator::operator++()
+{
+  if(++index_ == leaf_->count)
+  {
+    leaf_ = leaf_->next;
+    index_ = 0;
+  }
+  return *this;
+}
+
+/**
+* Postfix version of operator++.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::iterator::operator++(int)
+{
+  iterator old = *this;
+  ++(*this);
+  return old;
+}
+
+/**
+* Moves the iterator back one item. Stepping back from end() goes to the largest item.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator&
+BTree<Key, Value, Fanout>::iterator::operator--()
+{
+  if(leaf_ == NULL)
+  {
+    leaf_ = tree_->tail_;
+    index_ = leaf_->count - 1;
+  }
+  else if(index_ == 0)
+  {
+    leaf_ = leaf_->prev;
+    index_ = leaf_->count - 1;
+  }
+  else
+  {
+    --index_;
+  }
+  return *this;
+}
+
+/**
+* Postfix version of operator--.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::iterator::operator--(int)
+{
+  iterator old = *this;
+  --(*this);
+  return old;
+}
+
+/*
+  -------------------------------------------
+  End implementations for the BTree::iterator class.
+  -------------------------------------------
+*/
+
+/*
+  ---------------------------------------------------
+  Begin implementations for the BTree::const_iterator class.
+  ---------------------------------------------------
+*/
+
+/**
+* A default constructor that initializes the iterator to NULL.
+*/
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::const_iterator::const_iterator() : it_() {}
+
+/**
+* Converts an iterator, so begin() and friends can be compared with const iterators.
+*/
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::const_iterator::const_iterator(const iterator& it) : it_(it) {}
+
+/**
+* Provides read only access to the item.
+*/
+template<typename Key, typename Value, int Fanout>
+const std::pair<const Key, Value>& BTree<Key, Value, Fanout>::const_iterator::operator*() const
+{
+  return *it_;
+}
+
+/**
+* Provides read only access to the address of the item.
+*/
+template<typename Key, typename Value, int Fanout>
+const std::pair<const Key, Value>* BTree<Key, Value, Fanout>::const_iterator::operator->() const
+{
+  return it_.operator->();
+}
+
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::const_iterator::operator==(const const_iterator& rhs) const
+{
+  return it_ == rhs.it_;
+}
+
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::const_iterator::operator!=(const const_iterator& rhs) const
+{
+  return it_ != rhs.it_;
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator&
+BTree<Key, Value, Fanout>::const_iterator::operator++()
+{
+  ++it_;
+  return *this;
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator
+BTree<Key, Value, Fanout>::const_iterator::operator++(int)
+{
+  const_iterator old = *this;
+  ++it_;
+  return old;
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator&
+BTree<Key, Value, Fanout>::const_iterator::operator--()
+{
+  --it_;
+  return *this;
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator
+BTree<Key, Value, Fanout>::const_iterator::operator--(int)
+{
+  const_iterator old = *this;
+  --it_;
+  return old;
+}
+
+/*
+  -------------------------------------------------
+  End implementations for the BTree::const_iterator class.
+  -------------------------------------------------
+*/
+
+/*
+  -----------------------------------
+  Begin implementations for the BTree class.
+  -----------------------------------
+*/
+
+template<typename Key, typename Value, int Fanout>
+const int BTree<Key, Value, Fanout>::MIN_LEAF;
+template<typename Key, typename Value, int Fanout>
+const int BTree<Key, Value, Fanout>::MIN_INNER;
+template<typename Key, typename Value, int Fanout>
+const int BTree<Key, Value, Fanout>::MAX_DEPTH;
+
+/**
+* Default constructor, the tree starts without any nodes.
+*/
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::BTree() : root_(NULL), head_(NULL), tail_(NULL), size_(0)
+{
+
+}
+
+template<typename Key, typename Value, int Fanout>
+BTree<Key, Value, Fanout>::~BTree()
+{
+  clear();
+}
+
+/**
+* Returns true if tree is empty
+*/
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::empty() const
+{
+  return root_ == NULL;
+}
+
+/**
+* Returns the number of items in the tree.
+*/
+template<typename Key, typename Value, int Fanout>
+std::size_t BTree<Key, Value, Fanout>::size() const
+{
+  return size_;
+}
+
+/**
+* Prints the items in key order, one per line.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::print() const
+{
+  for(iterator it = begin(); it != end(); ++it)
+  {
+    std::cout << it->first << " " << it->second << "\n";
+  }
+}
+
+/**
+* Returns an iterator to the "smallest" item in the tree
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::begin() const
+{
+  return iterator(head_, 0, this);
+}
+
+/**
+* Returns an iterator whose value means INVALID
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::end() const
+{
+  return iterator(NULL, 0, this);
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator
+BTree<Key, Value, Fanout>::cbegin() const
+{
+  return const_iterator(begin());
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_iterator
+BTree<Key, Value, Fanout>::cend() const
+{
+  return const_iterator(end());
+}
+
+/**
+* Returns a reverse iterator to the "largest" item in the tree
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::reverse_iterator
+BTree<Key, Value, Fanout>::rbegin() const
+{
+  return reverse_iterator(end());
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::reverse_iterator
+BTree<Key, Value, Fanout>::rend() const
+{
+  return reverse_iterator(begin());
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_reverse_iterator
+BTree<Key, Value, Fanout>::crbegin() const
+{
+  return const_reverse_iterator(cend());
+}
+
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::const_reverse_iterator
+BTree<Key, Value, Fanout>::crend() const
+{
+  return const_reverse_iterator(cbegin());
+}
+
+/**
+* Returns an iterator to the item with the given key, or end() if there is none.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::find(const Key& key) const
+{
+  iterator it = lower_bound(key);
+  if(it != end() && key < it->first)
+  {
+    return end();
+  }
+  return it;
+}
+
+/**
+* Returns an iterator to the first item whose key is not less than key, or end().
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::lower_bound(const Key& key) const
+{
+  if(root_ == NULL)
+  {
+    return end();
+  }
+
+  int depth = 0;
+  Leaf* leaf = findLeaf(key, NULL, depth);
+  return leafIterator(leaf, lowerIndex(leaf->keys, leaf->count, key));
+}
+
+/**
+* Returns an iterator to the first item whose key is greater than key, or end().
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::upper_bound(const Key& key) const
+{
+  if(root_ == NULL)
+  {
+    return end();
+  }
+
+  int depth = 0;
+  Leaf* leaf = findLeaf(key, NULL, depth);
+  return leafIterator(leaf, upperIndex(leaf->keys, leaf->count, key));
+}
+
+/**
+* Returns the value of the item with the given key, throws std::out_of_range
+* if there is none.
+*/
+template<typename Key, typename Value, int Fanout>
+Value& BTree<Key, Value, Fanout>::operator[](const Key& key)
+{
+  iterator it = find(key);
+  if(it == end()) throw std::out_of_range("Invalid key");
+  return it->second;
+}
+
+template<typename Key, typename Value, int Fanout>
+Value const & BTree<Key, Value, Fanout>::operator[](const Key& key) const
+{
+  iterator it = find(key);
+  if(it == end()) throw std::out_of_range("Invalid key");
+  return it->second;
+}
+
+/**
+* Calls f on every item in key order. The items of a leaf sit next to each other,
+* so this is a straight walk along the leaf chain.
+*/
+template<typename Key, typename Value, int Fanout>
+template<typename Func>
+void BTree<Key, Value, Fanout>::for_each(Func f) const
+{
+  for(Leaf* leaf = head_; leaf != NULL; leaf = leaf->next)
+  {
+    for(int i = 0; i < leaf->count; ++i)
+    {
+      f(static_cast<const Item&>(leaf->item(i)));
+    }
+  }
+}
+
+/**
+* Inserts the item, or overwrites the value if the key is already in the tree.
+* A full leaf is split in two on the way, and the split moves up through full
+* inner nodes as far as needed, growing a new root if it reaches the top.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+  if(root_ == NULL)
+  {
+    head_ = tail_ = newLeaf();
+    root_ = head_;
+  }
+
+  PathStep path[MAX_DEPTH];
+  int depth = 0;
+  Leaf* leaf = findLeaf(keyValuePair.first, path, depth);
+  int pos = lowerIndex(leaf->keys, leaf->count, keyValuePair.first);
+  if(pos < leaf->count && !(keyValuePair.first < leaf->keys[pos]))
+  {
+    leaf->item(pos).second = keyValuePair.second;
+    return;
+  }
+
+  if(leaf->count == Fanout)
+  {
+    Leaf* right = splitLeaf(leaf);
+    insertSeparator(path, depth, right->keys[0], right);
+
+    //a key between the two halves stays at the end of the left one
+    if(pos > leaf->count)
+    {
+      pos -= leaf->count;
+      leaf = right;
+    }
+  }
+
+  insertItem(leaf, pos, keyValuePair);
+  ++size_;
+}
+
+/**
+* Removes the item with the given key, if there is one. A leaf that gets less than
+* half full borrows an item from a neighbour or merges with it, which can take a
+* separator away from the parent and carry on up the tree.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::remove(const Key& key)
+{
+  if(root_ == NULL)
+  {
+    return;
+  }
+
+  PathStep path[MAX_DEPTH];
+  int depth = 0;
+  Leaf* leaf = findLeaf(key, path, depth);
+  int pos = lowerIndex(leaf->keys, leaf->count, key);
+  if(pos == leaf->count || key < leaf->keys[pos])
+  {
+    return;
+  }
+
+  leaf->item(pos).~Item();
+  for(int i = pos + 1; i < leaf->count; ++i)
+  {
+    moveItem(leaf, i, leaf, i - 1);
+  }
+  --leaf->count;
+  --size_;
+
+  //fix underfull nodes bottom up until a parent keeps all of its keys
+  NodeBase* node = leaf;
+  while(depth > 0 && node->count < (node->leaf ? MIN_LEAF : MIN_INNER))
+  {
+    --depth;
+    if(!fixUnderflow(path[depth].node, path[depth].child))
+    {
+      break;
+    }
+    node = path[depth].node;
+  }
+
+  //the root goes away once it is an empty leaf or an inner node with one child
+  if(root_->count == 0)
+  {
+    if(root_->leaf)
+    {
+      delete static_cast<Leaf*>(root_);
+      root_ = NULL;
+      head_ = tail_ = NULL;
+    }
+    else
+    {
+      Inner* old = static_cast<Inner*>(root_);
+      root_ = old->children[0];
+      delete old;
+    }
+  }
+}
+
+/**
+* Deletes every node and item.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::clear()
+{
+  doClear(root_);
+  root_ = NULL;
+  head_ = tail_ = NULL;
+  size_ = 0;
+}
+
+/**
+* Returns true if every leaf is at the same depth, every node but the root is at
+* least half full, and all keys are in order and between their separators.
+*/
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::isBalanced() const
+{
+  int leafDepth = -1;
+  return root_ == NULL || checkNode(root_, 0, leafDepth, NULL, NULL);
+}
+
+/**
+* Returns the first index whose key is not less than key, see KeySearch in
+* simd-search.h for how the node is searched.
+*/
+template<typename Key, typename Value, int Fanout>
+int BTree<Key, Value, Fanout>::lowerIndex(const Key* keys, int count, const Key& key)
+{
+  return KeySearch<Key>::lower(keys, count, key);
+}
+
+/**
+* Returns the first index whose key is greater than key, see lowerIndex.
+*/
+template<typename Key, typename Value, int Fanout>
+int BTree<Key, Value, Fanout>::upperIndex(const Key* keys, int count, const Key& key)
+{
+  return KeySearch<Key>::upper(keys, count, key);
+}
+
+/**
+* Walks down to the leaf whose key range holds key. If path is not NULL, every inner
+* node passed and the child taken are recorded in it and depth is their number.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::Leaf*
+BTree<Key, Value, Fanout>::findLeaf(const Key& key, PathStep* path, int& depth) const
+{
+  NodeBase* node = root_;
+  while(!node->leaf)
+  {
+    Inner* inner = static_cast<Inner*>(node);
+    prefetchKeys(inner->keys, inner->count);
+    int child = upperIndex(inner->keys, inner->count, key);
+    if(path != NULL)
+    {
+      path[depth].node = inner;
+      path[depth].child = child;
+      ++depth;
+    }
+    node = inner->children[child];
+  }
+
+  Leaf* leaf = static_cast<Leaf*>(node);
+  prefetchKeys(leaf->keys, leaf->count);
+  return leaf;
+}
+
+/**
+* Asks for every cache line of a node's keys at once. The binary search would
+* otherwise wait for each line in turn, one miss after the other.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::prefetchKeys(const Key* keys, int count)
+{
+  const char* first = reinterpret_cast<const char*>(keys);
+  const char* last = reinterpret_cast<const char*>(keys + count);
+  for(const char* line = first; line < last; line += 64)
+  {
+    BST_PREFETCH(line);
+  }
+}
+
+//my helper function, index may be one past the end of the leaf
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::iterator
+BTree<Key, Value, Fanout>::leafIterator(Leaf* leaf, int index) const
+{
+  if(index == leaf->count)
+  {
+    return iterator(leaf->next, 0, this);
+  }
+  return iterator(leaf, index, this);
+}
+
+//my helper function
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::Leaf* BTree<Key, Value, Fanout>::newLeaf()
+{
+  Leaf* leaf = new Leaf;
+  leaf->count = 0;
+  leaf->leaf = true;
+  leaf->prev = NULL;
+  leaf->next = NULL;
+  return leaf;
+}
+
+//my helper function
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::Inner* BTree<Key, Value, Fanout>::newInner()
+{
+  Inner* inner = new Inner;
+  inner->count = 0;
+  inner->leaf = false;
+  return inner;
+}
+
+//my helper function, moves item i of from into the empty slot j of to
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::moveItem(Leaf* from, int i, Leaf* to, int j)
+{
+  new (&to->slots[j]) Item(std::move(from->item(i)));
+  from->item(i).~Item();
+  to->keys[j] = from->keys[i];
+}
+
+//my helper function, puts key at pos and child right after it
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::insertChild(Inner* inner, int pos, const Key& key, NodeBase* child)
+{
+  for(int i = inner->count; i > pos; --i)
+  {
+    inner->keys[i] = inner->keys[i - 1];
+    inner->children[i + 1] = inner->children[i];
+  }
+  inner->keys[pos] = key;
+  inner->children[pos + 1] = child;
+  ++inner->count;
+}
+
+//my helper function, takes out the key at pos and the child right after it
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::removeChild(Inner* inner, int pos)
+{
+  for(int i = pos + 1; i < inner->count; ++i)
+  {
+    inner->keys[i - 1] = inner->keys[i];
+    inner->children[i] = inner->children[i + 1];
+  }
+  --inner->count;
+}
+
+/**
+* Puts a copy of keyValuePair at pos of a leaf that is not full. If the copy
+* throws, the leaf is put back the way it was.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::insertItem(Leaf* leaf, int pos, const std::pair<const Key, Value>& keyValuePair)
+{
+  for(int i = leaf->count; i > pos; --i)
+  {
+    moveItem(leaf, i - 1, leaf, i);
+  }
+
+  try
+  {
+    new (&leaf->slots[pos]) Item(keyValuePair);
+  }
+  catch(...)
+  {
+    for(int i = pos; i < leaf->count; ++i)
+    {
+      moveItem(leaf, i + 1, leaf, i);
+    }
+    throw;
+  }
+
+  leaf->keys[pos] = keyValuePair.first;
+  ++leaf->count;
+}
+
+/**
+* Moves the upper half of a full leaf into a new leaf linked in after it,
+* and returns the new leaf.
+*/
+template<typename Key, typename Value, int Fanout>
+typename BTree<Key, Value, Fanout>::Leaf* BTree<Key, Value, Fanout>::splitLeaf(Leaf* leaf)
+{
+  Leaf* right = newLeaf();
+  int keep = Fanout / 2;
+  for(int i = keep; i < leaf->count; ++i)
+  {
+    moveItem(leaf, i, right, i - keep);
+  }
+  right->count = leaf->count - keep;
+  leaf->count = keep;
+
+  right->prev = leaf;
+  right->next = leaf->next;
+  if(leaf->next != NULL)
+  {
+    leaf->next->prev = right;
+  }
+  else
+  {
+    tail_ = right;
+  }
+  leaf->next = right;
+  return right;
+}
+
+/**
+* Adds the separator key and the new node right of it to the parent at the end of
+* path. A full parent is split around its middle key, which then goes up a level
+* in the same way, and a split root gets a new root above it.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::insertSeparator(PathStep* path, int depth, Key key, NodeBase* right)
+{
+  while(depth > 0)
+  {
+    --depth;
+    Inner* inner = path[depth].node;
+    int pos = path[depth].child;
+    if(inner->count < Fanout)
+    {
+      insertChild(inner, pos, key, right);
+      return;
+    }
+
+    //keys[0, mid) stay, keys[mid] goes up and the rest move to sibling
+    Inner* sibling = newInner();
+    int mid = Fanout / 2;
+    Key up = inner->keys[mid];
+    sibling->count = Fanout - mid - 1;
+    for(int i = 0; i < sibling->count; ++i)
+    {
+      sibling->keys[i] = inner->keys[mid + 1 + i];
+    }
+    for(int i = 0; i <= sibling->count; ++i)
+    {
+      sibling->children[i] = inner->children[mid + 1 + i];
+    }
+    inner->count = mid;
+
+    if(pos <= mid)
+    {
+      insertChild(inner, pos, key, right);
+    }
+    else
+    {
+      insertChild(sibling, pos - mid - 1, key, right);
+    }
+    key = up;
+    right = sibling;
+  }
+
+  Inner* root = newInner();
+  root->count = 1;
+  root->keys[0] = key;
+  root->children[0] = root_;
+  root->children[1] = right;
+  root_ = root;
+}
+
+/**
+* Refills the underfull child of parent from a neighbour that can spare a key, or
+* merges it with a neighbour. Returns true if parent lost a key by a merge.
+*/
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::fixUnderflow(Inner* parent, int child)
+{
+  NodeBase* node = parent->children[child];
+  NodeBase* left = (child > 0 ? parent->children[child - 1] : NULL);
+  NodeBase* right = (child < parent->count ? parent->children[child + 1] : NULL);
+
+  if(node->leaf)
+  {
+    Leaf* leaf = static_cast<Leaf*>(node);
+    if(left != NULL && left->count > MIN_LEAF)
+    {
+      Leaf* from = static_cast<Leaf*>(left);
+      for(int i = leaf->count; i > 0; --i)
+      {
+        moveItem(leaf, i - 1, leaf, i);
+      }
+      moveItem(from, from->count - 1, leaf, 0);
+      --from->count;
+      ++leaf->count;
+      parent->keys[child - 1] = leaf->keys[0];
+      return false;
+    }
+    if(right != NULL && right->count > MIN_LEAF)
+    {
+      Leaf* from = static_cast<Leaf*>(right);
+      moveItem(from, 0, leaf, leaf->count);
+      for(int i = 1; i < from->count; ++i)
+      {
+        moveItem(from, i, from, i - 1);
+      }
+      --from->count;
+      ++leaf->count;
+      parent->keys[child] = from->keys[0];
+      return false;
+    }
+
+    if(left != NULL)
+    {
+      mergeLeaves(static_cast<Leaf*>(left), leaf);
+      removeChild(parent, child - 1);
+    }
+    else
+    {
+      mergeLeaves(leaf, static_cast<Leaf*>(right));
+      removeChild(parent, child);
+    }
+    return true;
+  }
+
+  //inner nodes rotate a key through the parent
+  Inner* inner = static_cast<Inner*>(node);
+  if(left != NULL && left->count > MIN_INNER)
+  {
+    Inner* from = static_cast<Inner*>(left);
+    insertChild(inner, 0, parent->keys[child - 1], inner->children[0]);
+    inner->children[0] = from->children[from->count];
+    parent->keys[child - 1] = from->keys[from->count - 1];
+    --from->count;
+    return false;
+  }
+  if(right != NULL && right->count > MIN_INNER)
+  {
+    Inner* from = static_cast<Inner*>(right);
+    inner->keys[inner->count] = parent->keys[child];
+    inner->children[inner->count + 1] = from->children[0];
+    ++inner->count;
+    parent->keys[child] = from->keys[0];
+    from->children[0] = from->children[1];
+    removeChild(from, 0);
+    return false;
+  }
+
+  mergeInners(parent, left != NULL ? child - 1 : child);
+  return true;
+}
+
+/**
+* Moves every item of right to the end of left, unlinks right and deletes it.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::mergeLeaves(Leaf* left, Leaf* right)
+{
+  for(int i = 0; i < right->count; ++i)
+  {
+    moveItem(right, i, left, left->count + i);
+  }
+  left->count += right->count;
+
+  left->next = right->next;
+  if(right->next != NULL)
+  {
+    right->next->prev = left;
+  }
+  else
+  {
+    tail_ = left;
+  }
+  delete right;
+}
+
+/**
+* Merges the children on both sides of the parent's key sep, pulling the key down
+* between them, and deletes the right one.
+*/
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::mergeInners(Inner* parent, int sep)
+{
+  Inner* left = static_cast<Inner*>(parent->children[sep]);
+  Inner* right = static_cast<Inner*>(parent->children[sep + 1]);
+
+  left->keys[left->count] = parent->keys[sep];
+  for(int i = 0; i < right->count; ++i)
+  {
+    left->keys[left->count + 1 + i] = right->keys[i];
+  }
+  for(int i = 0; i <= right->count; ++i)
+  {
+    left->children[left->count + 1 + i] = right->children[i];
+  }
+  left->count += 1 + right->count;
+
+  removeChild(parent, sep);
+  delete right;
+}
+
+//my helper function, the tree is only log_Fanout(n) deep so recursion is fine
+template<typename Key, typename Value, int Fanout>
+void BTree<Key, Value, Fanout>::doClear(NodeBase* node)
+{
+  if(node == NULL)
+  {
+    return;
+  }
+
+  if(node->leaf)
+  {
+    Leaf* leaf = static_cast<Leaf*>(node);
+    for(int i = 0; i < leaf->count; ++i)
+    {
+      leaf->item(i).~Item();
+    }
+    delete leaf;
+    return;
+  }
+
+  Inner* inner = static_cast<Inner*>(node);
+  for(int i = 0; i <= inner->count; ++i)
+  {
+    doClear(inner->children[i]);
+  }
+  delete inner;
+}
+
+//my helper function, lo and hi bound the keys of node and are NULL at the edges
+template<typename Key, typename Value, int Fanout>
+bool BTree<Key, Value, Fanout>::checkNode(const NodeBase* node, int depth, int& leafDepth,
+    const Key* lo, const Key* hi) const
+{
+  int minimum = (node == root_ ? 1 : (node->leaf ? MIN_LEAF : MIN_INNER));
+  if(node->count < minimum || node->count > Fanout)
+  {
+    return false;
+  }
+
+  const Key* keys = (node->leaf ? static_cast<const Leaf*>(node)->keys : static_cast<const Inner*>(node)->keys);
+  for(int i = 0; i < node->count; ++i)
+  {
+    if((i > 0 && !(keys[i - 1] < keys[i])) || (lo != NULL && keys[i] < *lo) || (hi != NULL && !(keys[i] < *hi)))
+    {
+      return false;
+    }
+  }
+
+  if(node->leaf)
+  {
+    if(leafDepth == -1)
+    {
+      leafDepth = depth;
+    }
+    return depth == leafDepth;
+  }
+
+  const Inner* inner = static_cast<const Inner*>(node);
+  for(int i = 0; i <= inner->count; ++i)
+  {
+    const Key* childLo = (i == 0 ? lo : &inner->keys[i - 1]);
+    const Key* childHi = (i == inner->count ? hi : &inner->keys[i]);
+    if(!checkNode(inner->children[i], depth + 1, leafDepth, childLo, childHi))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  ---------------------------------
+  End implementations for the BTree class.
+  ---------------------------------
+*/
+
+#endif
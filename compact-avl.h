@@ -0,0 +1,1353 @@
+#ifndef COMPACT_AVL_H
+#define COMPACT_AVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+/**
+* An AVL tree with compact node storage. It supports the map part of AVLTree's
+* interface: insert, emplace, try_emplace, insert_or_assign, remove, clear, find,
+* the bounds, operator[], empty, print, isBalanced and iteration both ways with
+* iterator, const_iterator and their reverse iterators. The hinted insert, the
+* augmentations and the bulk operations of AVLTree are not available.
+* Nodes live in one contiguous pool and refer to each other by uint32_t index
+* instead of by pointer. The balance of each node is packed into the top two
+* bits of its parent index, so a node costs the payload plus 12 bytes of links.
+* Up to 2^30 - 1 nodes can be stored.
+*/
+template <typename Key, typename Value>
+class CompactAVLTree
+{
+  public:
+    CompactAVLTree();
+    ~CompactAVLTree();
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    template<typename P>
+    typename std::enable_if<!std::is_lvalue_reference<P>::value &&
+                            std::is_constructible<std::pair<Key, Value>, P>::value>::type
+    insert(P&& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool isBalanced() const;
+    void print() const;
+    bool empty() const;
+
+    /**
+    * An iterator over the pool. It holds an index rather than a pointer, so it
+    * stays valid when the pool grows.
+    */
+    class iterator
+    {
+      public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::pair<const Key, Value> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::pair<const Key, Value>* pointer;
+        typedef std::pair<const Key, Value>& reference;
+
+        iterator();
+
+        std::pair<const Key,Value>& operator*() const;
+        std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+        iterator operator++(int);
+        iterator& operator--();
+        iterator operator--(int);
+
+      protected:
+        friend class CompactAVLTree<Key, Value>;
+        iterator(const CompactAVLTree<Key, Value>* tree, uint32_t index);
+        const CompactAVLTree<Key, Value>* tree_;
+        uint32_t index_;
+    };
+
+    /**
+    * The same as iterator, but the items can only be read.
+    */
+    class const_iterator
+    {
+      public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef std::pair<const Key, Value> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::pair<const Key, Value>* pointer;
+        typedef const std::pair<const Key, Value>& reference;
+
+        const_iterator();
+        const_iterator(const iterator& it);
+
+        const std::pair<const Key,Value>& operator*() const;
+        const std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const const_iterator& rhs) const;
+        bool operator!=(const const_iterator& rhs) const;
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+
+      private:
+        iterator it_;
+    };
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  public:
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+    iterator find(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    std::pair<iterator, iterator> equal_range(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+    // Move aware insertion, these work like the ones of BinarySearchTree
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value);
+
+  protected:
+    /**
+    * One pool entry. parent holds the parent index in its low 30 bits and the
+    * balance plus one in its top 2 bits. Free slots have every parent bit set
+    * and chain to the next free slot through right.
+    */
+    struct Slot
+    {
+      std::pair<const Key, Value> item;
+      uint32_t parent;
+      uint32_t left;
+      uint32_t right;
+    };
+
+    static const uint32_t NIL = 0x3FFFFFFF;
+    static const uint32_t INDEX_MASK = 0x3FFFFFFF;
+    static const uint32_t FREE = 0xFFFFFFFF;
+
+    // Packed link accessors
+    uint32_t getParent(uint32_t i) const;
+    int getBalance(uint32_t i) const;
+    void setParent(uint32_t i, uint32_t parent);
+    void setBalance(uint32_t i, int balance);
+
+    // Pool management
+    template<typename... Args>
+    uint32_t allocSlot(uint32_t parent, Args&&... args);
+    void freeSlot(uint32_t i);
+    void grow();
+
+    // Tree helpers
+    uint32_t internalFind(const Key& key) const;
+    uint32_t findSlot(const Key& key, uint32_t& parent) const;
+    uint32_t boundSlot(const Key& key, bool strict) const;
+    uint32_t largest() const;
+    void linkSlot(uint32_t node);
+    template<typename KeyArg, typename V>
+    std::pair<iterator, bool> assignSlot(KeyArg&& key, V&& value);
+    template<typename KeyArg, typename... Args>
+    std::pair<iterator, bool> emplaceSlot(KeyArg&& key, Args&&... args);
+    uint32_t successor(uint32_t i) const;
+    uint32_t predecessor(uint32_t i) const;
+    void replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild);
+    void rotateLeft(uint32_t node);
+    void rotateRight(uint32_t node);
+    uint32_t rebalance(uint32_t node, int balance, bool& shrank);
+    void insertFix(uint32_t node);
+    void removeFix(uint32_t node, bool leftShrank);
+
+  private:
+    // The pool owns its slots, so the tree cannot be copied.
+    CompactAVLTree(const CompactAVLTree& other);
+    CompactAVLTree& operator=(const CompactAVLTree& other);
+
+  protected:
+    Slot* pool_;
+    uint32_t capacity_;
+    uint32_t used_;
+    uint32_t free_;
+    uint32_t root_;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the CompactAVLTree::iterator class.
+--------------------------------------------------------------
+*/
+
+/**
+* A default constructor that initializes the iterator to the end.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::iterator::iterator() : tree_(NULL), index_(NIL) {}
+
+/**
+* Explicit constructor that initializes an iterator with a tree and pool index.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::iterator::iterator(const CompactAVLTree<Key, Value>* tree, uint32_t index) :
+  tree_(tree), index_(index) {}
+
+/**
+* Provides access to the item.
+*/
+template<class Key, class Value>
+std::pair<const Key,Value>& CompactAVLTree<Key, Value>::iterator::operator*() const
+{
+  return tree_->pool_[index_].item;
+}
+
+/**
+* Provides access to the address of the item.
+*/
+template<class Key, class Value>
+std::pair<const Key,Value>* CompactAVLTree<Key, Value>::iterator::operator->() const
+{
+  return &(tree_->pool_[index_].item);
+}
+
+/**
+* Checks if 'this' iterator refers to the same slot as 'rhs'
+*/
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+  return index_ == rhs.index_;
+}
+
+/**
+* Checks if 'this' iterator refers to a different slot than 'rhs'
+*/
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+  return index_ != rhs.index_;
+}
+
+/**
+* Advances the iterator's location using an in-order sequencing
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator&
+CompactAVLTree<Key, Value>::iterator::operator++()
+{
+  index_ = tree_->successor(index_);
+  return *this;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::iterator::operator++(int)
+{
+  iterator old = *this;
+  ++(*this);
+  return old;
+}
+
+/**
+* Steps back to the previous item in order. Stepping back from end()
+* gives the largest item.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator&
+CompactAVLTree<Key, Value>::iterator::operator--()
+{
+  index_ = (index_ == NIL) ? tree_->largest() : tree_->predecessor(index_);
+  return *this;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::iterator::operator--(int)
+{
+  iterator old = *this;
+  --(*this);
+  return old;
+}
+
+/*
+------------------------------------------------------------
+End implementations for the CompactAVLTree::iterator class.
+------------------------------------------------------------
+*/
+
+/*
+--------------------------------------------------------------------
+Begin implementations for the CompactAVLTree::const_iterator class.
+--------------------------------------------------------------------
+*/
+
+/**
+* A default constructor that initializes the iterator to the end.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::const_iterator::const_iterator() : it_() {}
+
+/**
+* Makes a read only copy of a mutable iterator.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::const_iterator::const_iterator(const iterator& it) : it_(it) {}
+
+template<class Key, class Value>
+const std::pair<const Key,Value>& CompactAVLTree<Key, Value>::const_iterator::operator*() const
+{
+  return *it_;
+}
+
+template<class Key, class Value>
+const std::pair<const Key,Value>* CompactAVLTree<Key, Value>::const_iterator::operator->() const
+{
+  return it_.operator->();
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::const_iterator::operator==(const const_iterator& rhs) const
+{
+  return it_ == rhs.it_;
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::const_iterator::operator!=(const const_iterator& rhs) const
+{
+  return it_ != rhs.it_;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator&
+CompactAVLTree<Key, Value>::const_iterator::operator++()
+{
+  ++it_;
+  return *this;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator
+CompactAVLTree<Key, Value>::const_iterator::operator++(int)
+{
+  const_iterator old = *this;
+  ++it_;
+  return old;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator&
+CompactAVLTree<Key, Value>::const_iterator::operator--()
+{
+  --it_;
+  return *this;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator
+CompactAVLTree<Key, Value>::const_iterator::operator--(int)
+{
+  const_iterator old = *this;
+  --it_;
+  return old;
+}
+
+/*
+------------------------------------------------------------------
+End implementations for the CompactAVLTree::const_iterator class.
+------------------------------------------------------------------
+*/
+
+/*
+--------------------------------------------------
+Begin implementations for the CompactAVLTree class.
+--------------------------------------------------
+*/
+
+/**
+* Default constructor, the pool is allocated on the first insert.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::CompactAVLTree() :
+  pool_(NULL), capacity_(0), used_(0), free_(NIL), root_(NIL) {}
+
+template<typename Key, typename Value>
+CompactAVLTree<Key, Value>::~CompactAVLTree()
+{
+  clear();
+}
+
+/**
+* Returns true if tree is empty
+*/
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::empty() const
+{
+  return root_ == NIL;
+}
+
+/**
+* Destroys every live item and frees the pool.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::clear()
+{
+  for(uint32_t i = 0; i < used_; ++i)
+  {
+    if(pool_[i].parent != FREE)
+    {
+      pool_[i].item.~pair();
+    }
+  }
+  ::operator delete(pool_);
+
+  pool_ = NULL;
+  capacity_ = 0;
+  used_ = 0;
+  free_ = NIL;
+  root_ = NIL;
+}
+
+/**
+* Prints the contents of the tree in order, one item per line.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::print() const
+{
+  for(iterator it = begin(); it != end(); ++it)
+  {
+    std::cout << it->first << " " << it->second << "\n";
+  }
+}
+
+/**
+* Returns an iterator to the "smallest" item in the tree
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::begin() const
+{
+  uint32_t temp = root_;
+  while(temp != NIL && pool_[temp].left != NIL)
+  {
+    temp = pool_[temp].left;
+  }
+  return iterator(this, temp);
+}
+
+/**
+* Returns an iterator whose value means INVALID
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::end() const
+{
+  return iterator(this, NIL);
+}
+
+/**
+* Read only versions of begin() and end().
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator
+CompactAVLTree<Key, Value>::cbegin() const
+{
+  return const_iterator(begin());
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_iterator
+CompactAVLTree<Key, Value>::cend() const
+{
+  return const_iterator(end());
+}
+
+/**
+* Returns a reverse iterator to the largest item.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::reverse_iterator
+CompactAVLTree<Key, Value>::rbegin() const
+{
+  return reverse_iterator(end());
+}
+
+/**
+* Returns the reverse iterator past the smallest item.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::reverse_iterator
+CompactAVLTree<Key, Value>::rend() const
+{
+  return reverse_iterator(begin());
+}
+
+/**
+* Read only versions of rbegin() and rend().
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_reverse_iterator
+CompactAVLTree<Key, Value>::crbegin() const
+{
+  return const_reverse_iterator(cend());
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::const_reverse_iterator
+CompactAVLTree<Key, Value>::crend() const
+{
+  return const_reverse_iterator(cbegin());
+}
+
+/**
+* Returns an iterator to the item with the given key, k
+* or the end iterator if k does not exist in the tree
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::find(const Key& key) const
+{
+  return iterator(this, internalFind(key));
+}
+
+/**
+* Returns an iterator to the first item whose key is not less than k,
+* or the end iterator if there is none.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::lower_bound(const Key& key) const
+{
+  return iterator(this, boundSlot(key, false));
+}
+
+/**
+* Returns an iterator to the first item whose key is greater than k,
+* or the end iterator if there is none.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::upper_bound(const Key& key) const
+{
+  return iterator(this, boundSlot(key, true));
+}
+
+/**
+* Returns the range of items with key k as [lower_bound(k), upper_bound(k)).
+* Keys are unique, so it holds at most one item.
+*/
+template<class Key, class Value>
+std::pair<typename CompactAVLTree<Key, Value>::iterator,
+          typename CompactAVLTree<Key, Value>::iterator>
+CompactAVLTree<Key, Value>::equal_range(const Key& key) const
+{
+  uint32_t first = boundSlot(key, false);
+  uint32_t last = first;
+  if(first != NIL && !(key < pool_[first].item.first))
+  {
+    last = successor(first);
+  }
+  return std::make_pair(iterator(this, first), iterator(this, last));
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value& CompactAVLTree<Key, Value>::operator[](const Key& key)
+{
+  uint32_t curr = internalFind(key);
+  if(curr == NIL) throw std::out_of_range("Invalid key");
+  return pool_[curr].item.second;
+}
+template<class Key, class Value>
+Value const & CompactAVLTree<Key, Value>::operator[](const Key& key) const
+{
+  uint32_t curr = internalFind(key);
+  if(curr == NIL) throw std::out_of_range("Invalid key");
+  return pool_[curr].item.second;
+}
+
+/**
+* Inserts the pair, or overwrites the value if the key is already in the tree.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+  uint32_t parent;
+  uint32_t found = findSlot(keyValuePair.first, parent);
+  if(found != NIL)
+  {
+    pool_[found].item.second = keyValuePair.second;
+    return;
+  }
+
+  //allocSlot may move the pool, so only indices are held across it
+  linkSlot(allocSlot(parent, keyValuePair));
+}
+
+/**
+* The same as insert, but the key and value of an rvalue pair are moved into
+* the tree.
+*/
+template<class Key, class Value>
+template<typename P>
+typename std::enable_if<!std::is_lvalue_reference<P>::value &&
+                        std::is_constructible<std::pair<Key, Value>, P>::value>::type
+CompactAVLTree<Key, Value>::insert(P&& keyValuePair)
+{
+  std::pair<Key, Value> keyValue(std::forward<P>(keyValuePair));
+  assignSlot(std::move(keyValue.first), std::move(keyValue.second));
+}
+
+/**
+* Builds a new item from args, like std::pair would, and links it in if its key
+* is not in the tree yet; otherwise the item is destroyed again. Returns an
+* iterator to the item with that key and whether it was inserted.
+*/
+template<class Key, class Value>
+template<typename... Args>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::emplace(Args&&... args)
+{
+  uint32_t newNode = allocSlot(NIL, std::forward<Args>(args)...);
+  uint32_t parent;
+  uint32_t found = findSlot(pool_[newNode].item.first, parent);
+  if(found != NIL)
+  {
+    freeSlot(newNode);
+    return std::make_pair(iterator(this, found), false);
+  }
+
+  setParent(newNode, parent);
+  linkSlot(newNode);
+  return std::make_pair(iterator(this, newNode), true);
+}
+
+/**
+* If key is not in the tree, inserts it with a value constructed in place
+* from args. Otherwise nothing happens and args are left untouched.
+*/
+template<class Key, class Value>
+template<typename... Args>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::try_emplace(const Key& key, Args&&... args)
+{
+  return emplaceSlot(key, std::forward<Args>(args)...);
+}
+
+template<class Key, class Value>
+template<typename... Args>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::try_emplace(Key&& key, Args&&... args)
+{
+  return emplaceSlot(std::move(key), std::forward<Args>(args)...);
+}
+
+/**
+* Inserts key with the given value, or assigns the value to the existing key.
+* The second member of the result is true if a new item was inserted.
+*/
+template<class Key, class Value>
+template<typename V>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::insert_or_assign(const Key& key, V&& value)
+{
+  return assignSlot(key, std::forward<V>(value));
+}
+
+template<class Key, class Value>
+template<typename V>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::insert_or_assign(Key&& key, V&& value)
+{
+  return assignSlot(std::move(key), std::forward<V>(value));
+}
+
+/**
+* Removes the key from the tree if it is present. A node with two children
+* is replaced by its predecessor, just like in AVLTree.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::remove(const Key& key)
+{
+  uint32_t curr = internalFind(key);
+  if(curr == NIL)
+  {
+    return;
+  }
+
+  uint32_t parent = getParent(curr);
+  uint32_t left = pool_[curr].left;
+  uint32_t right = pool_[curr].right;
+
+  //0 or 1 child, splice the child into curr's place
+  if(left == NIL || right == NIL)
+  {
+    uint32_t child = (left != NIL) ? left : right;
+    bool wasLeft = (parent != NIL && pool_[parent].left == curr);
+
+    if(child != NIL)
+    {
+      setParent(child, parent);
+    }
+    replaceChild(parent, curr, child);
+    freeSlot(curr);
+
+    if(parent != NIL)
+    {
+      removeFix(parent, wasLeft);
+    }
+    return;
+  }
+
+  //2 child case, the predecessor takes over curr's links
+  uint32_t pred = left;
+  while(pool_[pred].right != NIL)
+  {
+    pred = pool_[pred].right;
+  }
+
+  uint32_t fixFrom;
+  bool leftShrank;
+  if(pred == left)
+  {
+    //pred moves up one level and keeps its own left subtree
+    fixFrom = pred;
+    leftShrank = true;
+  }
+  else
+  {
+    //unhook pred, its left subtree takes its place
+    uint32_t predParent = getParent(pred);
+    uint32_t predLeft = pool_[pred].left;
+    pool_[predParent].right = predLeft;
+    if(predLeft != NIL)
+    {
+      setParent(predLeft, predParent);
+    }
+
+    pool_[pred].left = left;
+    setParent(left, pred);
+    fixFrom = predParent;
+    leftShrank = false;
+  }
+
+  pool_[pred].right = right;
+  setParent(right, pred);
+  setParent(pred, parent);
+  setBalance(pred, getBalance(curr));
+  replaceChild(parent, curr, pred);
+  freeSlot(curr);
+
+  removeFix(fixFrom, leftShrank);
+}
+
+/**
+ * Return true iff every node's subtrees differ in height by at most one.
+ */
+template<typename Key, typename Value>
+bool CompactAVLTree<Key, Value>::isBalanced() const
+{
+  if(root_ == NIL)
+  {
+    return true;
+  }
+
+  //iterative post order, height of each finished subtree is kept on a stack
+  std::vector<uint32_t> path;
+  std::vector<int> heights;
+  uint32_t curr = root_;
+  uint32_t last = NIL;
+
+  while(curr != NIL || !path.empty())
+  {
+    if(curr != NIL)
+    {
+      path.push_back(curr);
+      curr = pool_[curr].left;
+      if(curr == NIL)
+      {
+        heights.push_back(0);
+      }
+      continue;
+    }
+
+    uint32_t top = path.back();
+    if(pool_[top].right != NIL && pool_[top].right != last)
+    {
+      curr = pool_[top].right;
+      continue;
+    }
+
+    if(pool_[top].right == NIL)
+    {
+      heights.push_back(0);
+    }
+
+    int right = heights.back();
+    heights.pop_back();
+    int left = heights.back();
+    heights.pop_back();
+    if(right - left > 1 || left - right > 1)
+    {
+      return false;
+    }
+    heights.push_back(1 + (left > right ? left : right));
+
+    last = top;
+    path.pop_back();
+  }
+
+  return true;
+}
+
+//my helper function
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::getParent(uint32_t i) const
+{
+  return pool_[i].parent & INDEX_MASK;
+}
+
+//my helper function
+template<typename Key, typename Value>
+int CompactAVLTree<Key, Value>::getBalance(uint32_t i) const
+{
+  return static_cast<int>(pool_[i].parent >> 30) - 1;
+}
+
+//my helper function
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::setParent(uint32_t i, uint32_t parent)
+{
+  pool_[i].parent = (pool_[i].parent & ~INDEX_MASK) | parent;
+}
+
+//my helper function
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::setBalance(uint32_t i, int balance)
+{
+  pool_[i].parent = (pool_[i].parent & INDEX_MASK) | (static_cast<uint32_t>(balance + 1) << 30);
+}
+
+/**
+* Constructs a new leaf in a free slot, with its item made from args as std::pair
+* would, and returns its index. This may reallocate the pool, so callers must not
+* hold references into it. If building the item throws, the slot stays free and
+* the tree is unchanged.
+*/
+template<typename Key, typename Value>
+template<typename... Args>
+uint32_t CompactAVLTree<Key, Value>::allocSlot(uint32_t parent, Args&&... args)
+{
+  bool reuse = (free_ != NIL);
+  if(!reuse && used_ == capacity_)
+  {
+    grow();
+  }
+  uint32_t i = reuse ? free_ : used_;
+
+  //the slot is only claimed once the item is built
+  new (&pool_[i].item) std::pair<const Key, Value>(std::forward<Args>(args)...);
+  if(reuse)
+  {
+    free_ = pool_[i].right;
+  }
+  else
+  {
+    ++used_;
+  }
+
+  pool_[i].parent = parent;
+  pool_[i].left = NIL;
+  pool_[i].right = NIL;
+  setBalance(i, 0);
+  return i;
+}
+
+/**
+* Destroys the item in a slot and puts the slot on the free list.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::freeSlot(uint32_t i)
+{
+  pool_[i].item.~pair();
+  pool_[i].parent = FREE;
+  pool_[i].right = free_;
+  free_ = i;
+}
+
+/**
+* Doubles the pool, moving every live item into the new storage. Items whose move
+* may throw are copied instead, and the old items are only destroyed once all of
+* them are across, so if anything throws the tree is left as it was.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::grow()
+{
+  if(capacity_ >= NIL)
+  {
+    throw std::length_error("CompactAVLTree is full");
+  }
+
+  uint32_t newCapacity = (capacity_ == 0) ? 16 : capacity_ * 2;
+  if(newCapacity > NIL || newCapacity < capacity_)
+  {
+    newCapacity = NIL;
+  }
+
+  Slot* newPool = static_cast<Slot*>(::operator new(sizeof(Slot) * static_cast<std::size_t>(newCapacity)));
+  uint32_t i = 0;
+  try
+  {
+    for(; i < used_; ++i)
+    {
+      if(pool_[i].parent != FREE)
+      {
+        new (&newPool[i].item) std::pair<const Key, Value>(std::move_if_noexcept(pool_[i].item));
+      }
+      newPool[i].parent = pool_[i].parent;
+      newPool[i].left = pool_[i].left;
+      newPool[i].right = pool_[i].right;
+    }
+  }
+  catch(...)
+  {
+    //undo the copies made so far, the old pool is untouched
+    for(uint32_t j = 0; j < i; ++j)
+    {
+      if(newPool[j].parent != FREE)
+      {
+        newPool[j].item.~pair();
+      }
+    }
+    ::operator delete(newPool);
+    throw;
+  }
+
+  for(i = 0; i < used_; ++i)
+  {
+    if(pool_[i].parent != FREE)
+    {
+      pool_[i].item.~pair();
+    }
+  }
+  ::operator delete(pool_);
+  pool_ = newPool;
+  capacity_ = newCapacity;
+}
+
+/**
+* Helper function to find the index of the node with the given key,
+* or NIL if no item with that key exists
+*/
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::internalFind(const Key& key) const
+{
+  uint32_t temp = root_;
+  while(temp != NIL)
+  {
+    const Key& curr = pool_[temp].item.first;
+    if(key == curr)
+    {
+      return temp;
+    }
+    temp = (key < curr) ? pool_[temp].left : pool_[temp].right;
+  }
+  return NIL;
+}
+
+/**
+* Returns the node with key, or NIL with parent set to the node a new leaf for
+* key goes below (NIL for an empty tree).
+*/
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::findSlot(const Key& key, uint32_t& parent) const
+{
+  uint32_t temp = root_;
+  parent = NIL;
+  while(temp != NIL)
+  {
+    const Key& curr = pool_[temp].item.first;
+    if(key == curr)
+    {
+      return temp;
+    }
+    parent = temp;
+    temp = (key < curr) ? pool_[temp].left : pool_[temp].right;
+  }
+  return NIL;
+}
+
+/**
+* Returns the first node whose key is not less than key, or greater than key
+* if strict is set, or NIL if there is none.
+*/
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::boundSlot(const Key& key, bool strict) const
+{
+  uint32_t temp = root_;
+  uint32_t bound = NIL;
+  while(temp != NIL)
+  {
+    const Key& curr = pool_[temp].item.first;
+    if(strict ? key < curr : !(curr < key))
+    {
+      bound = temp;
+      temp = pool_[temp].left;
+    }
+    else
+    {
+      temp = pool_[temp].right;
+    }
+  }
+  return bound;
+}
+
+//my helper function
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::largest() const
+{
+  uint32_t temp = root_;
+  while(temp != NIL && pool_[temp].right != NIL)
+  {
+    temp = pool_[temp].right;
+  }
+  return temp;
+}
+
+/**
+* Hangs a new leaf, whose parent is already set, below its parent (or makes it
+* the root) and rebalances.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::linkSlot(uint32_t node)
+{
+  uint32_t parent = getParent(node);
+  if(parent == NIL)
+  {
+    root_ = node;
+    return;
+  }
+
+  if(pool_[node].item.first < pool_[parent].item.first)
+  {
+    pool_[parent].left = node;
+  }
+  else
+  {
+    pool_[parent].right = node;
+  }
+  insertFix(node);
+}
+
+/**
+* insert_or_assign for either kind of key.
+*/
+template<typename Key, typename Value>
+template<typename KeyArg, typename V>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::assignSlot(KeyArg&& key, V&& value)
+{
+  uint32_t parent;
+  uint32_t found = findSlot(key, parent);
+  if(found != NIL)
+  {
+    pool_[found].item.second = std::forward<V>(value);
+    return std::make_pair(iterator(this, found), false);
+  }
+
+  uint32_t newNode = allocSlot(parent, std::forward<KeyArg>(key), std::forward<V>(value));
+  linkSlot(newNode);
+  return std::make_pair(iterator(this, newNode), true);
+}
+
+/**
+* try_emplace for either kind of key, args are only used for a new item.
+*/
+template<typename Key, typename Value>
+template<typename KeyArg, typename... Args>
+std::pair<typename CompactAVLTree<Key, Value>::iterator, bool>
+CompactAVLTree<Key, Value>::emplaceSlot(KeyArg&& key, Args&&... args)
+{
+  uint32_t parent;
+  uint32_t found = findSlot(key, parent);
+  if(found != NIL)
+  {
+    return std::make_pair(iterator(this, found), false);
+  }
+
+  uint32_t newNode = allocSlot(parent, std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArg>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+  linkSlot(newNode);
+  return std::make_pair(iterator(this, newNode), true);
+}
+
+//my helper function
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::successor(uint32_t i) const
+{
+  if(pool_[i].right != NIL)
+  {
+    i = pool_[i].right;
+    while(pool_[i].left != NIL)
+    {
+      i = pool_[i].left;
+    }
+    return i;
+  }
+
+  //climb until we come up from a left child
+  uint32_t parent = getParent(i);
+  while(parent != NIL && pool_[parent].right == i)
+  {
+    i = parent;
+    parent = getParent(i);
+  }
+  return parent;
+}
+
+//my helper function, the mirror image of successor
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::predecessor(uint32_t i) const
+{
+  if(pool_[i].left != NIL)
+  {
+    i = pool_[i].left;
+    while(pool_[i].right != NIL)
+    {
+      i = pool_[i].right;
+    }
+    return i;
+  }
+
+  //climb until we come up from a right child
+  uint32_t parent = getParent(i);
+  while(parent != NIL && pool_[parent].left == i)
+  {
+    i = parent;
+    parent = getParent(i);
+  }
+  return parent;
+}
+
+//my helper function
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::replaceChild(uint32_t parent, uint32_t oldChild, uint32_t newChild)
+{
+  if(parent == NIL)
+  {
+    root_ = newChild;
+  }
+  else if(pool_[parent].left == oldChild)
+  {
+    pool_[parent].left = newChild;
+  }
+  else
+  {
+    pool_[parent].right = newChild;
+  }
+}
+
+//my helper function, only fixes links, balances are set by the caller
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::rotateLeft(uint32_t node)
+{
+  uint32_t right = pool_[node].right;
+  uint32_t parent = getParent(node);
+  uint32_t middle = pool_[right].left;
+
+  pool_[node].right = middle;
+  if(middle != NIL)
+  {
+    setParent(middle, node);
+  }
+
+  setParent(right, parent);
+  replaceChild(parent, node, right);
+
+  pool_[right].left = node;
+  setParent(node, right);
+}
+
+//my helper function, only fixes links, balances are set by the caller
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::rotateRight(uint32_t node)
+{
+  uint32_t left = pool_[node].left;
+  uint32_t parent = getParent(node);
+  uint32_t middle = pool_[left].right;
+
+  pool_[node].left = middle;
+  if(middle != NIL)
+  {
+    setParent(middle, node);
+  }
+
+  setParent(left, parent);
+  replaceChild(parent, node, left);
+
+  pool_[left].right = node;
+  setParent(node, left);
+}
+
+/**
+* Restores the AVL property at node, whose balance has reached +/-2. The packed
+* field can only hold -1..1, so the out of range balance is passed in. Returns
+* the new root of the subtree and sets shrank if the subtree lost height.
+*/
+template<typename Key, typename Value>
+uint32_t CompactAVLTree<Key, Value>::rebalance(uint32_t node, int balance, bool& shrank)
+{
+  if(balance == 2)
+  {
+    uint32_t right = pool_[node].right;
+    int rightBalance = getBalance(right);
+
+    //zig-zig
+    if(rightBalance >= 0)
+    {
+      rotateLeft(node);
+      setBalance(node, rightBalance == 0 ? 1 : 0);
+      setBalance(right, rightBalance == 0 ? -1 : 0);
+      shrank = (rightBalance != 0);
+      return right;
+    }
+
+    //zig-zag
+    uint32_t grandChild = pool_[right].left;
+    int grandBalance = getBalance(grandChild);
+    rotateRight(right);
+    rotateLeft(node);
+    setBalance(node, grandBalance == 1 ? -1 : 0);
+    setBalance(right, grandBalance == -1 ? 1 : 0);
+    setBalance(grandChild, 0);
+    shrank = true;
+    return grandChild;
+  }
+
+  uint32_t left = pool_[node].left;
+  int leftBalance = getBalance(left);
+
+  //zig-zig
+  if(leftBalance <= 0)
+  {
+    rotateRight(node);
+    setBalance(node, leftBalance == 0 ? -1 : 0);
+    setBalance(left, leftBalance == 0 ? 1 : 0);
+    shrank = (leftBalance != 0);
+    return left;
+  }
+
+  //zig-zag
+  uint32_t grandChild = pool_[left].right;
+  int grandBalance = getBalance(grandChild);
+  rotateLeft(left);
+  rotateRight(node);
+  setBalance(node, grandBalance == -1 ? 1 : 0);
+  setBalance(left, grandBalance == 1 ? -1 : 0);
+  setBalance(grandChild, 0);
+  shrank = true;
+  return grandChild;
+}
+
+/**
+* Walks up from a new leaf updating balances until a subtree stops growing.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::insertFix(uint32_t node)
+{
+  uint32_t child = node;
+  uint32_t parent = getParent(child);
+
+  while(parent != NIL)
+  {
+    int balance = getBalance(parent) + (pool_[parent].left == child ? -1 : 1);
+    if(balance == 0)
+    {
+      setBalance(parent, 0);
+      return;
+    }
+    if(balance == 1 || balance == -1)
+    {
+      setBalance(parent, balance);
+      child = parent;
+      parent = getParent(parent);
+      continue;
+    }
+
+    //a rotation after an insert always restores the old height
+    bool shrank;
+    rebalance(parent, balance, shrank);
+    return;
+  }
+}
+
+/**
+* Walks up from node, one of whose subtrees just lost height, until a
+* subtree keeps its height.
+*/
+template<typename Key, typename Value>
+void CompactAVLTree<Key, Value>::removeFix(uint32_t node, bool leftShrank)
+{
+  while(node != NIL)
+  {
+    int balance = getBalance(node) + (leftShrank ? 1 : -1);
+    if(balance == 1 || balance == -1)
+    {
+      setBalance(node, balance);
+      return;
+    }
+
+    if(balance != 0)
+    {
+      bool shrank;
+      node = rebalance(node, balance, shrank);
+      if(!shrank)
+      {
+        return;
+      }
+    }
+    else
+    {
+      setBalance(node, 0);
+    }
+
+    uint32_t parent = getParent(node);
+    leftShrank = (parent != NIL && pool_[parent].left == node);
+    node = parent;
+  }
+}
+
+/*
+------------------------------------------------
+End implementations for the CompactAVLTree class.
+------------------------------------------------
+*/
+
+#endif
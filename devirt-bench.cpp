@@ -0,0 +1,58 @@
+#include <iostream>
+#include <cstdlib>
+#include "bst.h"
+#include "avlbst.h"
+#include "bench.h"
+
+using namespace std;
+
+// Built twice by the Makefile: once as is and once with -DBST_VIRTUAL_NODES,
+// so the two binaries compare static and virtual child access.
+#ifdef BST_VIRTUAL_NODES
+static const char* DISPATCH = "virtual";
+#else
+static const char* DISPATCH = "static";
+#endif
+
+template<typename Tree>
+void runLookups(const char* name, int n, int lookups)
+{
+    vector<int> keys = shuffledKeys(n, 104);
+    Tree tree;
+    for(int i = 0; i < n; ++i) {
+        tree.insert(std::make_pair(keys[i], i));
+    }
+
+    // probe in a different random order than the inserts
+    vector<int> probes = shuffledKeys(n, 7);
+    long long found = 0;
+    BenchTimer timer;
+    for(int i = 0; i < lookups; ++i) {
+        if(tree.find(probes[i % n]) != tree.end()) {
+            ++found;
+        }
+    }
+    double secs = timer.seconds();
+    benchKeep(found);
+
+    cout << DISPATCH << "," << name << "," << n << "," << lookups << ","
+         << secs * 1e9 / lookups << "," << (1e-6 * lookups / secs) << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int lookups = 2000000;
+    if(argc > 1) {
+        lookups = atoi(argv[1]);
+    }
+
+    cout << "# sizeof(Node<int,int>)=" << sizeof(Node<int,int>)
+         << " sizeof(AVLNode<int,int>)=" << sizeof(AVLNode<int,int>) << endl;
+    cout << "dispatch,tree,nodes,lookups,ns_per_lookup,mlookups_per_sec" << endl;
+    int sizes[] = {1000, 100000, 1000000};
+    for(int i = 0; i < 3; ++i) {
+        runLookups<BinarySearchTree<int,int> >("bst", sizes[i], lookups);
+        runLookups<AVLTree<int,int> >("avl", sizes[i], lookups);
+    }
+    return 0;
+}
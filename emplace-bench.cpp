@@ -0,0 +1,96 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "bst.h"
+#include "avlbst.h"
+#include "bench.h"
+
+using namespace std;
+
+typedef vector<int> Payload;
+
+// Long keys so copying them costs a heap allocation
+static string makeKey(int i)
+{
+    string key = "customer-record-key-";
+    string digits = to_string(i);
+    key.append(24 - digits.size(), '0');
+    key += digits;
+    return key;
+}
+
+static void report(const char* tree, const char* op, int n, double secs)
+{
+    cout << tree << "," << op << "," << n << "," << secs * 1e9 / n << endl;
+}
+
+template<typename Tree>
+void runInserts(const char* name, const vector<int>& order, int payloadSize)
+{
+    int n = order.size();
+
+    // copying insert of an lvalue pair
+    {
+        Tree tree;
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            pair<const string, Payload> item(makeKey(order[i]), Payload(payloadSize, i));
+            tree.insert(item);
+        }
+        report(name, "insert_copy", n, timer.seconds());
+
+        // overwrite every key through the copying insert
+        timer.restart();
+        for(int i = 0; i < n; ++i) {
+            pair<const string, Payload> item(makeKey(order[i]), Payload(payloadSize, -i));
+            tree.insert(item);
+        }
+        report(name, "update_copy", n, timer.seconds());
+    }
+
+    // rvalue insert, key and value are moved into the node
+    {
+        Tree tree;
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            tree.insert(make_pair(makeKey(order[i]), Payload(payloadSize, i)));
+        }
+        report(name, "insert_move", n, timer.seconds());
+
+        // overwrite every key by moving the new value in
+        timer.restart();
+        for(int i = 0; i < n; ++i) {
+            tree.insert_or_assign(makeKey(order[i]), Payload(payloadSize, -i));
+        }
+        report(name, "update_insert_or_assign", n, timer.seconds());
+    }
+
+    // value constructed in place inside the node
+    {
+        Tree tree;
+        BenchTimer timer;
+        for(int i = 0; i < n; ++i) {
+            tree.try_emplace(makeKey(order[i]), payloadSize, i);
+        }
+        report(name, "try_emplace", n, timer.seconds());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int n = 200000;
+    int payloadSize = 64;
+    if(argc > 1) {
+        n = atoi(argv[1]);
+    }
+    if(argc > 2) {
+        payloadSize = atoi(argv[2]);
+    }
+
+    vector<int> order = shuffledKeys(n, 104);
+    cout << "tree,op,n,ns_per_op" << endl;
+    runInserts<BinarySearchTree<string, Payload> >("bst", order, payloadSize);
+    runInserts<AVLTree<string, Payload> >("avl", order, payloadSize);
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cstdlib>
+#include <vector>
 #include "equal-paths.h"
 using namespace std;
 
@@ -11,6 +12,9 @@ Node* d;
 Node* e;
 Node* f;
 
+// number of tests that gave the wrong answer, which is also the exit status
+int failures = 0;
+
 void setNode(Node* n, int key, Node* left=NULL, Node* right=NULL)
 {
   n->key = key;
@@ -18,17 +22,28 @@ void setNode(Node* n, int key, Node* left=NULL, Node* right=NULL)
   n->right = right;
 }
 
+void report(const char* msg, Node* root, bool expected)
+{
+  bool result = equalPaths(root);
+  cout << msg << ": " << result << endl;
+  if(result != expected)
+  {
+    cout << "FAILED: " << msg << " should be " << expected << endl;
+    ++failures;
+  }
+}
+
 void test1(const char* msg)
 {
   setNode(a,1,NULL, NULL);
-  cout << msg << ": " <<   equalPaths(a) << endl;
+  report(msg, a, true);
 }
 
 void test2(const char* msg)
 {
   setNode(a,1,b,NULL);
   setNode(b,2,NULL,NULL);
-  cout << msg << ": " <<   equalPaths(a) << endl;
+  report(msg, a, true);
 }
 
 void test3(const char* msg)
@@ -36,14 +51,14 @@ void test3(const char* msg)
   setNode(a,1,b,c);
   setNode(b,2,NULL,NULL);
   setNode(c,3,NULL,NULL);
-  cout << msg << ": " <<   equalPaths(a) << endl;
+  report(msg, a, true);
 }
 
 void test4(const char* msg)
 {
   setNode(a,1,NULL,c);
   setNode(c,3,NULL,NULL);
-  cout << msg << ": " <<   equalPaths(a) << endl;
+  report(msg, a, true);
 }
 
 void test5(const char* msg)
@@ -52,7 +67,51 @@ void test5(const char* msg)
   setNode(b,2,NULL,d);
   setNode(c,3,NULL,NULL);
   setNode(d,4,NULL,NULL);
-  cout << msg << ": " <<   equalPaths(a) << endl;
+  report(msg, a, false);
+}
+
+// the first leaf found is the odd one out
+void test6(const char* msg)
+{
+  setNode(a,1,b,c);
+  setNode(b,2,NULL,NULL);
+  setNode(c,3,d,e);
+  setNode(d,4,NULL,NULL);
+  setNode(e,5,NULL,NULL);
+  report(msg, a, false);
+}
+
+// only the last leaf found is the odd one out
+void test7(const char* msg)
+{
+  setNode(a,1,b,c);
+  setNode(b,2,d,e);
+  setNode(c,3,NULL,NULL);
+  setNode(d,4,NULL,NULL);
+  setNode(e,5,NULL,NULL);
+  report(msg, a, false);
+}
+
+void test8(const char* msg)
+{
+  report(msg, NULL, true);
+}
+
+// a path far deeper than the call stack could take, first on its own and then
+// with a leaf hanging off its top
+void test9(const char* msg, const char* msg2)
+{
+  const int depth = 1000000;
+  vector<Node> chain(depth, Node(0));
+  for(int i = 0; i + 1 < depth; ++i)
+  {
+    setNode(&chain[i], i, NULL, &chain[i + 1]);
+  }
+  report(msg, &chain[0], true);
+
+  Node leaf(-1);
+  chain[0].left = &leaf;
+  report(msg2, &chain[0], false);
 }
 
 int main()
@@ -61,16 +120,22 @@ int main()
   b = new Node(2);
   c = new Node(3);
   d = new Node(4);
+  e = new Node(5);
 
   test1("Test1");
   test2("Test2");
   test3("Test3");
   test4("Test4");
   test5("Test5");
- 
+  test6("Test6");
+  test7("Test7");
+  test8("Test8");
+  test9("Test9", "Test10");
+
   delete a;
   delete b;
   delete c;
   delete d;
+  delete e;
+  return failures;
 }
-
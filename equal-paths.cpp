@@ -1,57 +1,19 @@
 #ifndef RECCHECK
 //if you want to add any #includes like <iostream> you must do them here (before the next endif)
-#include <algorithm>
+#include <vector>
+#include <utility>
 #endif
 
 #include "equal-paths.h"
 
 using namespace std;
 
-int getHeight(Node* curr)
-{
-	int heightL = -1;
-	int heightR = -1;
-
-	if(curr == NULL)
-	{
-		return 0;
-	}
-
-	if(curr->left != NULL)
-	{
-		heightL = getHeight(curr->left);
-	}
-
-	if(curr->right != NULL)
-	{
-		heightR = getHeight(curr->right);
-	}
-
-	return  1 + std::max(heightL, heightR);
-}
-
-bool dopaths(Node* root)
-{
-    int right = getHeight(root->right);
-    int left = getHeight(root->left);
-
-    // Add your code below
-    if(right != left)
-    {
-        return false;
-    }
-
-   //Check if there are subtrees under us
-	if(right == left)
-	{
-		equalPaths(root->left);
-		equalPaths(root->right);
-	}
-	
-	//If all nodes are balanced return true!
-	return true;
-}
-
+/**
+ * Visits the nodes depth first with an explicit stack, so even very deep trees
+ * are safe. The depth of the first leaf found is remembered and every later leaf
+ * is compared against it, stopping at the first one that differs.
+ * Each node is visited at most once, so this is O(n).
+ */
 bool equalPaths(Node* root)
 {
     if(root == NULL)
@@ -59,10 +21,40 @@ bool equalPaths(Node* root)
         return true;
     }
 
-    return dopaths(root);
-}
-
-
-
+    //each entry is a node and its depth below root
+    vector<pair<Node*, int> > stack;
+    stack.push_back(make_pair(root, 0));
+    int leafDepth = -1;
 
+    while(!stack.empty())
+    {
+        Node* curr = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
+        if(curr->left == NULL && curr->right == NULL)
+        {
+            if(leafDepth == -1)
+            {
+                leafDepth = depth;
+            }
+            else if(depth != leafDepth)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        //push right first so the left side is explored first
+        if(curr->right != NULL)
+        {
+            stack.push_back(make_pair(curr->right, depth + 1));
+        }
+        if(curr->left != NULL)
+        {
+            stack.push_back(make_pair(curr->left, depth + 1));
+        }
+    }
 
+    return true;
+}
@@ -0,0 +1,331 @@
+#ifndef FROZEN_INDEX_H
+#define FROZEN_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "prefetch.h"
+
+/**
+* An allocator whose blocks start on a cache line boundary. operator new only
+* promises alignof(std::max_align_t), so the block is padded and the address
+* operator new returned is kept in the word just below the aligned start.
+*/
+template<typename T>
+struct CacheLineAllocator
+{
+  typedef T value_type;
+  static const std::size_t LINE = 64;
+
+  CacheLineAllocator() {}
+  template<typename U>
+  CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+  T* allocate(std::size_t n)
+  {
+    void* raw = ::operator new(n * sizeof(T) + LINE + sizeof(void*));
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+    std::uintptr_t aligned = (start + LINE - 1) & ~static_cast<std::uintptr_t>(LINE - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<T*>(aligned);
+  }
+
+  void deallocate(T* p, std::size_t)
+  {
+    ::operator delete(reinterpret_cast<void**>(p)[-1]);
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&)
+{
+  return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const CacheLineAllocator<T>&, const CacheLineAllocator<U>&)
+{
+  return false;
+}
+
+/**
+* A read only snapshot of a search tree, see BinarySearchTree::freeze().
+* The keys are stored in one array in Eytzinger order: the array is the tree in
+* breadth first order, so the children of slot k are slots 2k and 2k + 1 and no
+* pointers are needed. A search walks down that array without branching on the
+* comparisons, and fetches the cache line holding the slots a few levels further
+* down (four for int keys) while it works on the current one. The key array
+* starts on a cache line, so for keys of 1 to 64 bytes (in powers of two) each of
+* those blocks of slots is exactly one line and one prefetch covers it. The items themselves
+* are kept in a second array in key order, which is what iteration walks and what
+* find and the bounds point into. Keys must be default constructible.
+*/
+template <typename Key, typename Value>
+class FrozenIndex
+{
+  public:
+    typedef typename std::vector<std::pair<Key, Value> >::const_iterator iterator;
+    typedef iterator const_iterator;
+
+    FrozenIndex();
+    template<typename InputIt>
+    FrozenIndex(InputIt first, InputIt last);
+    template<typename InputIt>
+    void assign(InputIt first, InputIt last);
+    void assign(std::vector<std::pair<Key, Value> >&& items);
+    void clear();
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    iterator lower_bound(const Key& key) const;
+    iterator upper_bound(const Key& key) const;
+    Value const & operator[](const Key& key) const;
+    bool empty() const;
+    std::size_t size() const;
+
+  private:
+    // Slots k * PREFETCH_SPAN and on are the descendants of slot k that many levels
+    // down, which is the largest power of two of keys that fit in a cache line.
+    static const std::size_t PREFETCH_SPAN = (sizeof(Key) <= 1 ? 64 : sizeof(Key) <= 2 ? 32 :
+                                              sizeof(Key) <= 4 ? 16 : sizeof(Key) <= 8 ? 8 :
+                                              sizeof(Key) <= 16 ? 4 : sizeof(Key) <= 32 ? 2 : 1);
+
+    std::size_t descend(const Key& key, bool strict) const;
+    static void checkOrder(const std::vector<std::pair<Key, Value> >& items);
+    void buildSlots();
+    void fillSlots(std::size_t slot, std::size_t& next);
+    static std::size_t lastLeftTurn(std::size_t slot);
+
+    std::vector<std::pair<Key, Value> > items_;       // in key order
+    std::vector<Key, CacheLineAllocator<Key> > keys_; // in Eytzinger order, slot 0 unused
+    std::vector<std::size_t> ranks_;                  // position in items_ of every slot
+};
+
+/**
+* Default constructor, an empty index.
+*/
+template<typename Key, typename Value>
+FrozenIndex<Key, Value>::FrozenIndex()
+{
+
+}
+
+/**
+* Builds an index from a range of key/value pairs sorted by strictly increasing key.
+*/
+template<typename Key, typename Value>
+template<typename InputIt>
+FrozenIndex<Key, Value>::FrozenIndex(InputIt first, InputIt last)
+{
+  assign(first, last);
+}
+
+/**
+* Replaces the contents with the pairs in [first, last), which must be sorted by
+* strictly increasing key, in O(n) and reusing the index's memory. The range is read
+* twice, so it needs forward iterators. Throws std::invalid_argument, leaving the
+* index untouched, if the keys are not sorted.
+*/
+template<typename Key, typename Value>
+template<typename InputIt>
+void FrozenIndex<Key, Value>::assign(InputIt first, InputIt last)
+{
+  //check the order before anything is thrown away
+  bool started = false;
+  for(InputIt prev = first, curr = first; curr != last; prev = curr, ++curr)
+  {
+    if(started && !(prev->first < curr->first))
+    {
+      throw std::invalid_argument("FrozenIndex needs keys in strictly increasing order");
+    }
+    started = true;
+  }
+
+  items_.assign(first, last);
+  buildSlots();
+}
+
+/**
+* Replaces the contents with items, which must be sorted by strictly increasing key,
+* in O(n) and without copying them. Throws std::invalid_argument, leaving the index
+* untouched, if the keys are not sorted.
+*/
+template<typename Key, typename Value>
+void FrozenIndex<Key, Value>::assign(std::vector<std::pair<Key, Value> >&& items)
+{
+  checkOrder(items);
+  items_.swap(items);
+  buildSlots();
+}
+
+/**
+* Removes every item.
+*/
+template<typename Key, typename Value>
+void FrozenIndex<Key, Value>::clear()
+{
+  items_.clear();
+  keys_.clear();
+  ranks_.clear();
+}
+
+template<typename Key, typename Value>
+typename FrozenIndex<Key, Value>::iterator FrozenIndex<Key, Value>::begin() const
+{
+  return items_.begin();
+}
+
+template<typename Key, typename Value>
+typename FrozenIndex<Key, Value>::iterator FrozenIndex<Key, Value>::end() const
+{
+  return items_.end();
+}
+
+/**
+* Returns an iterator to the item with the given key, or end() if there is none.
+*/
+template<typename Key, typename Value>
+typename FrozenIndex<Key, Value>::iterator FrozenIndex<Key, Value>::find(const Key& key) const
+{
+  iterator it = lower_bound(key);
+  if(it != end() && key < it->first)
+  {
+    return end();
+  }
+  return it;
+}
+
+/**
+* Returns an iterator to the first item whose key is not less than key, or end().
+*/
+template<typename Key, typename Value>
+typename FrozenIndex<Key, Value>::iterator FrozenIndex<Key, Value>::lower_bound(const Key& key) const
+{
+  std::size_t slot = descend(key, false);
+  return slot == 0 ? end() : items_.begin() + ranks_[slot];
+}
+
+/**
+* Returns an iterator to the first item whose key is greater than key, or end().
+*/
+template<typename Key, typename Value>
+typename FrozenIndex<Key, Value>::iterator FrozenIndex<Key, Value>::upper_bound(const Key& key) const
+{
+  std::size_t slot = descend(key, true);
+  return slot == 0 ? end() : items_.begin() + ranks_[slot];
+}
+
+/**
+* Returns the value of the item with the given key, throws std::out_of_range
+* if there is none.
+*/
+template<typename Key, typename Value>
+Value const & FrozenIndex<Key, Value>::operator[](const Key& key) const
+{
+  iterator it = find(key);
+  if(it == end()) throw std::out_of_range("Invalid key");
+  return it->second;
+}
+
+template<typename Key, typename Value>
+bool FrozenIndex<Key, Value>::empty() const
+{
+  return items_.empty();
+}
+
+template<typename Key, typename Value>
+std::size_t FrozenIndex<Key, Value>::size() const
+{
+  return items_.size();
+}
+
+/**
+* Walks from the root to past the bottom of the implicit tree, going right while
+* the slot's key is less than key (or not greater, if strict). The comparison is
+* added to the index instead of branched on, so the loop only branches on its
+* length, which is the same for every search. Returns the slot of the first key
+* that sent the walk left, i.e. the bound, or 0 if there is none.
+*/
+template<typename Key, typename Value>
+std::size_t FrozenIndex<Key, Value>::descend(const Key& key, bool strict) const
+{
+  const std::size_t n = items_.size();
+  const Key* keys = keys_.data();
+  std::size_t slot = 1;
+  while(slot <= n)
+  {
+    if(slot * PREFETCH_SPAN <= n)
+    {
+      BST_PREFETCH(keys + slot * PREFETCH_SPAN);
+    }
+    bool right = (strict ? !(key < keys[slot]) : keys[slot] < key);
+    slot = 2 * slot + (right ? 1 : 0);
+  }
+  return lastLeftTurn(slot);
+}
+
+/**
+* Strips the right turns taken after the last left turn off a slot past the bottom,
+* plus that left turn itself, which leaves the slot where the walk went left.
+*/
+template<typename Key, typename Value>
+std::size_t FrozenIndex<Key, Value>::lastLeftTurn(std::size_t slot)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  //slot is far below 2^64, so ~slot always has a set bit
+  return slot >> (__builtin_ctzll(~static_cast<unsigned long long>(slot)) + 1);
+#else
+  while(slot & 1)
+  {
+    slot >>= 1;
+  }
+  return slot >> 1;
+#endif
+}
+
+//my helper function
+template<typename Key, typename Value>
+void FrozenIndex<Key, Value>::checkOrder(const std::vector<std::pair<Key, Value> >& items)
+{
+  for(std::size_t i = 1; i < items.size(); ++i)
+  {
+    if(!(items[i - 1].first < items[i].first))
+    {
+      throw std::invalid_argument("FrozenIndex needs keys in strictly increasing order");
+    }
+  }
+}
+
+//my helper function, lays the keys of items_ out in Eytzinger order
+template<typename Key, typename Value>
+void FrozenIndex<Key, Value>::buildSlots()
+{
+  keys_.resize(items_.size() + 1);
+  ranks_.resize(items_.size() + 1);
+
+  //an in order walk over the implicit tree visits the slots in key order
+  std::size_t next = 0;
+  fillSlots(1, next);
+}
+
+//my helper function, hands out items_ positions to the slots in key order
+template<typename Key, typename Value>
+void FrozenIndex<Key, Value>::fillSlots(std::size_t slot, std::size_t& next)
+{
+  if(slot >= keys_.size())
+  {
+    return;
+  }
+
+  fillSlots(2 * slot, next);
+  keys_[slot] = items_[next].first;
+  ranks_[slot] = next;
+  ++next;
+  fillSlots(2 * slot + 1, next);
+}
+
+#endif
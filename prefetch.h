@@ -0,0 +1,15 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+/**
+ * Hints the CPU to start loading memory before it is needed, so the cache miss
+ * overlaps with other work. The tree scans, BTree and FrozenIndex all use it;
+ * it is a no-op on compilers without __builtin_prefetch.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define BST_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define BST_PREFETCH(addr) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,679 @@
+#ifndef RBBST_H
+#define RBBST_H
+
+#include <iostream>
+#include <utility>
+#include "bst.h"
+
+/**
+* A node of a red-black tree, which adds its color to the plain Node. New nodes
+* start out red.
+*/
+template <typename Key, typename Value>
+class RBNode : public Node<Key, Value>
+{
+  public:
+    // Constructor/destructor.
+    RBNode(const Key& key, const Value& value, RBNode<Key, Value>* parent);
+    template<typename KeyArg, typename... ValueArgs>
+    RBNode(RBNode<Key, Value>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs);
+    template<typename... Args>
+    RBNode(RBNode<Key, Value>* parent, EmplaceItem, Args&&... args);
+    BST_NODE_VIRTUAL ~RBNode() BST_NODE_OVERRIDE = default;
+
+    // Getter/setter for the node's color.
+    bool isRed() const;
+    void setRed(bool red);
+
+    // Getters for parent, left, and right, which hide the Node getters like the
+    // ones of AVLNode do.
+    BST_NODE_VIRTUAL RBNode<Key, Value>* getParent() const BST_NODE_OVERRIDE;
+    BST_NODE_VIRTUAL RBNode<Key, Value>* getLeft() const BST_NODE_OVERRIDE;
+    BST_NODE_VIRTUAL RBNode<Key, Value>* getRight() const BST_NODE_OVERRIDE;
+
+  protected:
+    bool red_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the RBNode class.
+  -------------------------------------------------
+*/
+
+/**
+* An explicit constructor to initialize the elements by calling the base class constructor
+*/
+template<class Key, class Value>
+RBNode<Key, Value>::RBNode(const Key& key, const Value& value, RBNode<Key, Value>* parent) :
+Node<Key, Value>(key, value, parent), red_(true)
+{
+
+}
+
+/**
+* An explicit constructor which builds the item in place, see the matching Node constructor
+*/
+template<class Key, class Value>
+template<typename KeyArg, typename... ValueArgs>
+RBNode<Key, Value>::RBNode(RBNode<Key, Value>* parent, std::piecewise_construct_t, KeyArg&& key, ValueArgs&&... valueArgs) :
+Node<Key, Value>(parent, std::piecewise_construct, std::forward<KeyArg>(key), std::forward<ValueArgs>(valueArgs)...), red_(true)
+{
+
+}
+
+template<class Key, class Value>
+template<typename... Args>
+RBNode<Key, Value>::RBNode(RBNode<Key, Value>* parent, EmplaceItem, Args&&... args) :
+Node<Key, Value>(parent, EmplaceItem(), std::forward<Args>(args)...), red_(true)
+{
+
+}
+
+/**
+* Returns true if the node is red, false if it is black.
+*/
+template<class Key, class Value>
+bool RBNode<Key, Value>::isRed() const
+{
+  return red_;
+}
+
+/**
+* Colors the node red, or black if red is false.
+*/
+template<class Key, class Value>
+void RBNode<Key, Value>::setRed(bool red)
+{
+  red_ = red;
+}
+
+/**
+* A redefined function for getting the parent since a static_cast is necessary to make sure
+* that our node is a RBNode.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>* RBNode<Key, Value>::getParent() const
+{
+  return static_cast<RBNode<Key, Value>*>(this->parent_);
+}
+
+/**
+* Redefined for the same reasons as above.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>* RBNode<Key, Value>::getLeft() const
+{
+  return static_cast<RBNode<Key, Value>*>(this->left_);
+}
+
+/**
+* Redefined for the same reasons as above.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>* RBNode<Key, Value>::getRight() const
+{
+  return static_cast<RBNode<Key, Value>*>(this->right_);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the RBNode class.
+  -----------------------------------------------
+*/
+
+
+/**
+* A self balancing red-black tree. Every path from a node down to a missing child
+* passes the same number of black nodes, and a red node has no red children, so
+* the tree is at most twice as deep as a perfectly balanced one. That is looser
+* than AVLTree, which pays off on updates: an insert does at most 2 rotations and
+* a remove at most 3, where an AVL remove can rotate at every level up to the
+* root. The rest of the fixup only recolors nodes. Lookups can be a little slower
+* since the tree is deeper. isBalanced() checks the stricter AVL condition, so
+* use isRedBlack() to check this tree.
+*/
+template <class Key, class Value, class Alloc = SlabArena>
+class RedBlackTree : public BinarySearchTree<Key, Value, Alloc>
+{
+  public:
+    typedef typename BinarySearchTree<Key, Value, Alloc>::iterator iterator;
+
+    RedBlackTree();
+    ~RedBlackTree();
+    using BinarySearchTree<Key, Value, Alloc>::insert;
+    virtual void insert(const std::pair<const Key, Value>& new_item) override;
+    virtual void remove(const Key& key);
+    virtual void clear();
+    bool isRedBlack() const;
+
+    // Move aware insertion, see BinarySearchTree
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value);
+    virtual iterator insert(iterator hint, const std::pair<const Key, Value>& new_item) override;
+
+  protected:
+    typedef RBNode<Key, Value> NodeType;
+
+    virtual void nodeSwap(NodeType* n1, NodeType* n2);
+    virtual std::pair<iterator, bool> moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite) override;
+    virtual bool plainNodes() const override;
+
+    // Add helper functions here
+    NodeType* root() const;
+    static bool redNode(const NodeType* node);
+    void insertFix(NodeType* node);
+    void removeFix(NodeType* node, NodeType* parent);
+    void rotateRight(NodeType* node);
+    void rotateLeft(NodeType* node);
+    static int blackHeight(const NodeType* node);
+};
+
+//constructor
+template<class Key, class Value, class Alloc>
+RedBlackTree<Key, Value, Alloc>::RedBlackTree() : BinarySearchTree<Key, Value, Alloc>() {}
+
+//destructor, the base class would free the nodes with the wrong type
+template<class Key, class Value, class Alloc>
+RedBlackTree<Key, Value, Alloc>::~RedBlackTree()
+{
+  clear();
+}
+
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::clear()
+{
+  this->clearNodes(root());
+  this->root_ = NULL;
+}
+
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::insert(const std::pair<const Key, Value>& new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  insert_or_assign(std::move(item.first), std::move(item.second));
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::emplace(Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceItemNode<NodeType>(std::forward<Args>(args)...);
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::try_emplace(const Key& key, Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(key, std::forward<Args>(args)...);
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::try_emplace(Key&& key, Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(std::move(key), std::forward<Args>(args)...);
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::insert_or_assign(const Key& key, V&& value)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(key, std::forward<V>(value));
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  else
+  {
+    result.first->getValue() = std::forward<V>(value);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::insert_or_assign(Key&& key, V&& value)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(std::move(key), std::forward<V>(value));
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  else
+  {
+    result.first->getValue() = std::forward<V>(value);
+  }
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+/**
+* Hinted insert, see BinarySearchTree. The new leaf is fixed up as usual, which is
+* amortized O(1) for a run of inserts.
+*/
+template<class Key, class Value, class Alloc>
+typename RedBlackTree<Key, Value, Alloc>::iterator
+RedBlackTree<Key, Value, Alloc>::insert(iterator hint, const std::pair<const Key, Value>& new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  std::pair<NodeType*, bool> result =
+    this->template emplaceNodeHint<NodeType>(this->hintNode(hint), std::move(item.first), std::move(item.second));
+  if(result.second)
+  {
+    insertFix(result.first);
+  }
+  else
+  {
+    result.first->setValue(std::move(item.second));
+  }
+  return this->makeIterator(result.first);
+}
+
+template<class Key, class Value, class Alloc>
+std::pair<typename RedBlackTree<Key, Value, Alloc>::iterator, bool>
+RedBlackTree<Key, Value, Alloc>::moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite)
+{
+  if(overwrite)
+  {
+    return insert_or_assign(std::move(keyValuePair.first), std::move(keyValuePair.second));
+  }
+  return try_emplace(std::move(keyValuePair.first), std::move(keyValuePair.second));
+}
+
+template<class Key, class Value, class Alloc>
+bool RedBlackTree<Key, Value, Alloc>::plainNodes() const
+{
+  return false;
+}
+
+/**
+* Restores the red-black rules after node was linked in as a new red leaf. While
+* node's parent is red too, a red uncle means the grandparent can take over the
+* red (recolor and move up two levels); a black uncle is fixed by one or two
+* rotations, after which the loop is done.
+*/
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::insertFix(NodeType* node)
+{
+  NodeType* parent = node->getParent();
+  while(redNode(parent))
+  {
+    //a red parent is never the root, so the grandparent exists
+    NodeType* grandParent = parent->getParent();
+
+    //p is left child of gp
+    if(grandParent->getLeft() == parent)
+    {
+      NodeType* uncle = grandParent->getRight();
+      if(redNode(uncle))
+      {
+        parent->setRed(false);
+        uncle->setRed(false);
+        grandParent->setRed(true);
+        node = grandParent;
+        parent = node->getParent();
+        continue;
+      }
+
+      //zig-zag, turn it into zig-zig first
+      if(node == parent->getRight())
+      {
+        rotateLeft(parent);
+        node = parent;
+        parent = node->getParent();
+      }
+
+      //zig-zig, left left
+      parent->setRed(false);
+      grandParent->setRed(true);
+      rotateRight(grandParent);
+    }
+
+    //p is right child of gp
+    else
+    {
+      NodeType* uncle = grandParent->getLeft();
+      if(redNode(uncle))
+      {
+        parent->setRed(false);
+        uncle->setRed(false);
+        grandParent->setRed(true);
+        node = grandParent;
+        parent = node->getParent();
+        continue;
+      }
+
+      //zig-zag, turn it into zig-zig first
+      if(node == parent->getLeft())
+      {
+        rotateRight(parent);
+        node = parent;
+        parent = node->getParent();
+      }
+
+      //zig-zig, right right
+      parent->setRed(false);
+      grandParent->setRed(true);
+      rotateLeft(grandParent);
+    }
+    break;
+  }
+
+  root()->setRed(false);
+}
+
+/*
+ * Recall: The writeup specifies that if a node has 2 children you
+ * should swap with the predecessor and then remove.
+ */
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::remove(const Key& key)
+{
+  //target node
+  NodeType* curr = static_cast<NodeType*>(this->internalFind(key));
+
+  //target not in tree
+  if(curr == NULL)
+  {
+    return;
+  }
+
+  //the largest node is found again lazily
+  if(curr == this->rightmost_)
+  {
+    this->rightmost_ = NULL;
+  }
+
+  //2 child case, after the swap curr has at most a left child
+  if((curr->getLeft() != NULL) && (curr->getRight() != NULL))
+  {
+    nodeSwap(static_cast<NodeType*>(this->predecessor(curr)), curr);
+  }
+
+  //splice curr out by linking its only child (if any) to its parent
+  NodeType* parent = curr->getParent();
+  NodeType* child = curr->getLeft();
+  if(child == NULL)
+  {
+    child = curr->getRight();
+  }
+
+  if(child != NULL)
+  {
+    child->setParent(parent);
+  }
+
+  if(parent == NULL)
+  {
+    this->root_ = child;
+  }
+  else if(parent->getLeft() == curr)
+  {
+    parent->setLeft(child);
+  }
+  else
+  {
+    parent->setRight(child);
+  }
+
+  //taking out a black node leaves its paths one black short
+  if(!curr->isRed())
+  {
+    removeFix(child, parent);
+  }
+
+  this->destroyNode(curr);
+}
+
+/**
+* Fixes the paths through node, which are one black node short after a remove.
+* node may be NULL, so its parent is passed along. A red node simply turns black.
+* Otherwise a red sibling is rotated up to get a black one; a black sibling with
+* black children turns red, which moves the shortage up to the parent; and a
+* black sibling with a red child lends a node across with one or two rotations,
+* which ends the loop. So only the recoloring can go all the way up.
+*/
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::removeFix(NodeType* node, NodeType* parent)
+{
+  while(parent != NULL && !redNode(node))
+  {
+    //node is left child of parent, its sibling cannot be NULL
+    if(parent->getLeft() == node)
+    {
+      NodeType* sibling = parent->getRight();
+      if(sibling->isRed())
+      {
+        sibling->setRed(false);
+        parent->setRed(true);
+        rotateLeft(parent);
+        sibling = parent->getRight();
+      }
+
+      if(!redNode(sibling->getLeft()) && !redNode(sibling->getRight()))
+      {
+        sibling->setRed(true);
+        node = parent;
+        parent = node->getParent();
+        continue;
+      }
+
+      //make the far child of the sibling the red one
+      if(!redNode(sibling->getRight()))
+      {
+        sibling->getLeft()->setRed(false);
+        sibling->setRed(true);
+        rotateRight(sibling);
+        sibling = parent->getRight();
+      }
+
+      sibling->setRed(parent->isRed());
+      parent->setRed(false);
+      sibling->getRight()->setRed(false);
+      rotateLeft(parent);
+    }
+
+    //node is right child of parent
+    else
+    {
+      NodeType* sibling = parent->getLeft();
+      if(sibling->isRed())
+      {
+        sibling->setRed(false);
+        parent->setRed(true);
+        rotateRight(parent);
+        sibling = parent->getLeft();
+      }
+
+      if(!redNode(sibling->getLeft()) && !redNode(sibling->getRight()))
+      {
+        sibling->setRed(true);
+        node = parent;
+        parent = node->getParent();
+        continue;
+      }
+
+      //make the far child of the sibling the red one
+      if(!redNode(sibling->getLeft()))
+      {
+        sibling->getRight()->setRed(false);
+        sibling->setRed(true);
+        rotateLeft(sibling);
+        sibling = parent->getLeft();
+      }
+
+      sibling->setRed(parent->isRed());
+      parent->setRed(false);
+      sibling->getLeft()->setRed(false);
+      rotateRight(parent);
+    }
+    return;
+  }
+
+  if(node != NULL)
+  {
+    node->setRed(false);
+  }
+}
+
+//my helper function
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::rotateRight(NodeType* node)
+{
+  NodeType* left = node->getLeft();
+  NodeType* parent = node->getParent();
+
+  //left takes node's place under parent
+  left->setParent(parent);
+  if(parent != NULL)
+  {
+    if(node == parent->getLeft())
+    {
+      parent->setLeft(left);
+    }
+    else
+    {
+      parent->setRight(left);
+    }
+  }
+  //node is the root
+  else
+  {
+    this->root_ = left;
+  }
+
+  //child switch case
+  node->setLeft(left->getRight());
+  if(left->getRight() != NULL)
+  {
+    left->getRight()->setParent(node);
+  }
+
+  left->setRight(node);
+  node->setParent(left);
+}
+
+//my helper function
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::rotateLeft(NodeType* node)
+{
+  NodeType* right = node->getRight();
+  NodeType* parent = node->getParent();
+
+  //right takes node's place under parent
+  right->setParent(parent);
+  if(parent != NULL)
+  {
+    if(node == parent->getRight())
+    {
+      parent->setRight(right);
+    }
+    else
+    {
+      parent->setLeft(right);
+    }
+  }
+  //node is the root
+  else
+  {
+    this->root_ = right;
+  }
+
+  //child switch case
+  node->setRight(right->getLeft());
+  if(right->getLeft() != NULL)
+  {
+    right->getLeft()->setParent(node);
+  }
+
+  right->setLeft(node);
+  node->setParent(right);
+}
+
+/**
+* Returns true if the tree follows the red-black rules: the root is black, no red
+* node has a red child and every path down passes the same number of black nodes.
+*/
+template<class Key, class Value, class Alloc>
+bool RedBlackTree<Key, Value, Alloc>::isRedBlack() const
+{
+  return !redNode(root()) && blackHeight(root()) >= 0;
+}
+
+//my helper function, the black height of node's subtree or -1 if it breaks the rules
+template<class Key, class Value, class Alloc>
+int RedBlackTree<Key, Value, Alloc>::blackHeight(const NodeType* node)
+{
+  if(node == NULL)
+  {
+    return 0;
+  }
+
+  if(node->isRed() && (redNode(node->getLeft()) || redNode(node->getRight())))
+  {
+    return -1;
+  }
+
+  int left = blackHeight(node->getLeft());
+  int right = blackHeight(node->getRight());
+  if(left < 0 || left != right)
+  {
+    return -1;
+  }
+  return left + (node->isRed() ? 0 : 1);
+}
+
+//my helper function
+template<class Key, class Value, class Alloc>
+RBNode<Key, Value>* RedBlackTree<Key, Value, Alloc>::root() const
+{
+  return static_cast<NodeType*>(this->root_);
+}
+
+//my helper function, missing children count as black
+template<class Key, class Value, class Alloc>
+bool RedBlackTree<Key, Value, Alloc>::redNode(const NodeType* node)
+{
+  return node != NULL && node->isRed();
+}
+
+template<class Key, class Value, class Alloc>
+void RedBlackTree<Key, Value, Alloc>::nodeSwap(NodeType* n1, NodeType* n2)
+{
+  BinarySearchTree<Key, Value, Alloc>::nodeSwap(n1, n2);
+
+  //the color belongs to the position, not the item
+  bool tempRed = n1->isRed();
+  n1->setRed(n2->isRed());
+  n2->setRed(tempRed);
+}
+
+#endif
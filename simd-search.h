@@ -0,0 +1,217 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * SIMD compares are used on x86-64 with GCC or Clang. SSE2 is part of the x86-64
+ * baseline, AVX2 is only used if the CPU reports it at run time, so the binaries
+ * run on any x86-64 machine. Build with -DBST_NO_SIMD to always use the scalar
+ * search (bst-bench-scalar compares the two).
+ */
+#if !defined(BST_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BST_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+* Searches a small sorted array of keys, such as the keys of a B-tree node.
+* lower() returns the first index whose key is not less than key, and upper() the
+* first index whose key is greater. This is a binary search that halves the range
+* without branching on the comparison (the compiler turns it into a conditional
+* move), since inside a node the outcome is a coin flip that a branch predictor
+* would mostly get wrong.
+*/
+template<typename Key>
+struct BinaryKeySearch
+{
+  static int lower(const Key* keys, int count, const Key& key)
+  {
+    if(count == 0)
+    {
+      return 0;
+    }
+
+    const Key* base = keys;
+    while(count > 1)
+    {
+      int half = count / 2;
+      base = (base[half - 1] < key ? base + half : base);
+      count -= half;
+    }
+    return (base - keys) + (*base < key ? 1 : 0);
+  }
+
+  static int upper(const Key* keys, int count, const Key& key)
+  {
+    if(count == 0)
+    {
+      return 0;
+    }
+
+    const Key* base = keys;
+    while(count > 1)
+    {
+      int half = count / 2;
+      base = (key < base[half - 1] ? base : base + half);
+      count -= half;
+    }
+    return (base - keys) + (key < *base ? 0 : 1);
+  }
+};
+
+/**
+* The key search used by BTree, which picks the fastest way to search for the
+* Key type at compile time. In general that is BinaryKeySearch.
+*/
+template<typename Key, typename Enable = void>
+struct KeySearch : BinaryKeySearch<Key>
+{
+};
+
+/**
+* 4 and 8 byte integer keys are counted instead of searched: every key below the
+* search key is one step further to the right, so lower() is the number of keys less
+* than key, and upper() the number not greater. A whole block of keys is compared
+* per step (4 with SSE2, 8 or 4 with AVX2) and the matches are added up lane by lane,
+* which never branches on the keys and reads the node front to back. Unsigned keys
+* have their top bit flipped so the signed compares order them correctly. 8 byte
+* keys need AVX2 for a 64 bit compare and fall back to the binary search without it.
+*/
+template<typename Key>
+struct KeySearch<Key, typename std::enable_if<std::is_integral<Key>::value &&
+                                              (sizeof(Key) == 4 || sizeof(Key) == 8)>::type>
+{
+  static int lower(const Key* keys, int count, const Key& key)
+  {
+#ifdef BST_SIMD_X86
+    if(sizeof(Key) == 4 || hasAvx2())
+    {
+      int done = 0;
+      int below = countBlocks(keys, count, key, false, done);
+      for(int i = done; i < count; ++i)
+      {
+        below += (keys[i] < key ? 1 : 0);
+      }
+      return below;
+    }
+#endif
+    return BinaryKeySearch<Key>::lower(keys, count, key);
+  }
+
+  static int upper(const Key* keys, int count, const Key& key)
+  {
+#ifdef BST_SIMD_X86
+    if(sizeof(Key) == 4 || hasAvx2())
+    {
+      int done = 0;
+      int above = countBlocks(keys, count, key, true, done);
+      int notAbove = done - above;
+      for(int i = done; i < count; ++i)
+      {
+        notAbove += (key < keys[i] ? 0 : 1);
+      }
+      return notAbove;
+    }
+#endif
+    return BinaryKeySearch<Key>::upper(keys, count, key);
+  }
+
+#ifdef BST_SIMD_X86
+  private:
+    typedef typename std::make_unsigned<Key>::type Bits;
+
+    // flipping the top bit maps unsigned order onto signed order
+    static const Bits FLIP = (std::is_signed<Key>::value ? Bits(0) : Bits(Bits(1) << (8 * sizeof(Key) - 1)));
+
+    /**
+    * Compares the keys a block at a time and returns how many are less than key, or
+    * greater than key if above is set. done is set to the number of keys covered,
+    * the rest (less than a block) is left to the caller. 8 byte keys need AVX2.
+    */
+    static int countBlocks(const Key* keys, int count, const Key& key, bool above, int& done)
+    {
+      Bits needle = static_cast<Bits>(key) ^ FLIP;
+      if(sizeof(Key) == 4)
+      {
+        const int32_t* data = reinterpret_cast<const int32_t*>(keys);
+        int32_t target = static_cast<int32_t>(static_cast<uint32_t>(needle));
+        int32_t flip = static_cast<int32_t>(static_cast<uint32_t>(FLIP));
+        return hasAvx2() ? count32Avx2(data, count, target, flip, above, done)
+                         : count32Sse2(data, count, target, flip, above, done);
+      }
+
+      const long long* data = reinterpret_cast<const long long*>(keys);
+      long long target = static_cast<long long>(static_cast<uint64_t>(needle));
+      long long flip = static_cast<long long>(static_cast<uint64_t>(FLIP));
+      return count64Avx2(data, count, target, flip, above, done);
+    }
+
+    //checked once, the answer cannot change while the program runs
+    static bool hasAvx2()
+    {
+      static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+      return avx2;
+    }
+
+    static int count32Sse2(const int32_t* keys, int count, int32_t target, int32_t flip, bool above, int& done)
+    {
+      const __m128i needle = _mm_set1_epi32(target);
+      const __m128i flipBits = _mm_set1_epi32(flip);
+      __m128i hits = _mm_setzero_si128();
+      int i = 0;
+      for(; i + 4 <= count; i += 4)
+      {
+        __m128i block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), flipBits);
+        //a true lane is all ones, i.e. -1
+        hits = _mm_sub_epi32(hits, above ? _mm_cmpgt_epi32(block, needle) : _mm_cmpgt_epi32(needle, block));
+      }
+      done = i;
+
+      int32_t lanes[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), hits);
+      return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    __attribute__((target("avx2")))
+    static int count32Avx2(const int32_t* keys, int count, int32_t target, int32_t flip, bool above, int& done)
+    {
+      const __m256i needle = _mm256_set1_epi32(target);
+      const __m256i flipBits = _mm256_set1_epi32(flip);
+      __m256i hits = _mm256_setzero_si256();
+      int i = 0;
+      for(; i + 8 <= count; i += 8)
+      {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flipBits);
+        hits = _mm256_sub_epi32(hits, above ? _mm256_cmpgt_epi32(block, needle) : _mm256_cmpgt_epi32(needle, block));
+      }
+      done = i;
+
+      int32_t lanes[8];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), hits);
+      return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+    }
+
+    __attribute__((target("avx2")))
+    static int count64Avx2(const long long* keys, int count, long long target, long long flip, bool above, int& done)
+    {
+      const __m256i needle = _mm256_set1_epi64x(target);
+      const __m256i flipBits = _mm256_set1_epi64x(flip);
+      __m256i hits = _mm256_setzero_si256();
+      int i = 0;
+      for(; i + 4 <= count; i += 4)
+      {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flipBits);
+        hits = _mm256_sub_epi64(hits, above ? _mm256_cmpgt_epi64(block, needle) : _mm256_cmpgt_epi64(needle, block));
+      }
+      done = i;
+
+      long long lanes[4];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), hits);
+      return static_cast<int>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+#endif
+};
+
+#endif
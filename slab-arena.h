@@ -0,0 +1,521 @@
+#ifndef SLAB_ARENA_H
+#define SLAB_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+/**
+* An allocator policy for search trees which hands out fixed size nodes from
+* large contiguous slabs. Freed nodes are kept on a free list and recycled by
+* later allocations, and all of the slabs can be given back at once by release().
+* A tree only ever allocates one kind of node, so the first allocation fixes the
+* object size of the arena. A larger object is a bug in the caller (release() could
+* not free it), so allocate() throws std::invalid_argument for one.
+*
+* Trees that split and join move nodes between each other, so a node may end up
+* being freed by a different arena than the one it came from. share() and absorb()
+* put two arenas in one group, whose slabs are only freed once every arena of the
+* group is gone, and until then a freed node simply goes on the free list of the
+* arena that freed it. Every arena keeps its own slabs and free list, so the trees
+* of one group can still be used from different threads; only the group itself is
+* shared, and it is locked by the rare calls that touch it (share, absorb, release,
+* canRelease and the destructor). A merged group forwards to the group that
+* absorbed it, and arenas still pointing at it follow the forward on their next
+* such call. Slabs are only released in bulk while an arena is alone in its group.
+*/
+class SlabArena
+{
+  public:
+    SlabArena();
+    ~SlabArena();
+
+    void* allocate(std::size_t bytes);
+    void deallocate(void* ptr, std::size_t bytes);
+    bool canRelease() const;
+    void release();
+    void share(SlabArena& other);
+    void absorb(SlabArena& other);
+
+  private:
+    // A slab is a header followed by room for slotCount objects.
+    struct Slab
+    {
+      Slab* next;
+    };
+
+    // Freed objects are threaded onto a singly linked list through their storage.
+    struct FreeSlot
+    {
+      FreeSlot* next;
+    };
+
+    // Arenas that may hold each other's objects, and the slabs they left behind.
+    struct Group
+    {
+      std::size_t refs;       // arenas in it plus groups forwarding to it
+      Slab* slabs;            // slabs of arenas that moved on, freed with the group
+      Slab* lastSlab;         // so slabs can be spliced on in O(1)
+      Group* forward;         // set once this group was absorbed into another one
+    };
+
+    // Arenas own their slabs, so they cannot be copied.
+    SlabArena(const SlabArena& other);
+    SlabArena& operator=(const SlabArena& other);
+
+    void setObjSize(std::size_t bytes);
+    void addSlab();
+    void handOverSlabs(Group* group);
+    void resetSlabs();
+    Group* group() const;
+    static Group* newGroup();
+    static void dropGroup(Group* group);
+    static void spliceSlabs(Slab*& slabs, Slab*& lastSlab, Slab* first, Slab* last);
+    static void freeSlabs(Slab* slabs);
+    static std::mutex& groupLock();
+    static std::size_t headerSize();
+
+    std::size_t objSize_;
+    std::size_t slotCount_;
+    Slab* slabs_;
+    Slab* lastSlab_;
+    char* next_;
+    char* end_;
+    FreeSlot* free_;
+    std::vector<FreeSlot*> spareFree_;  // free lists of absorbed arenas
+    mutable Group* group_;              // only used under groupLock()
+
+    static const std::size_t FIRST_SLAB_SLOTS = 32;
+    static const std::size_t MAX_SLAB_SLOTS = 4096;
+};
+
+/**
+* An allocator policy that simply forwards to operator new/delete, which
+* is how the trees managed their nodes before SlabArena.
+*/
+class HeapAllocator
+{
+  public:
+    void* allocate(std::size_t bytes);
+    void deallocate(void* ptr, std::size_t bytes);
+    bool canRelease() const;
+    void release();
+    void share(HeapAllocator& other);
+    void absorb(HeapAllocator& other);
+};
+
+/*
+  -------------------------------------------
+  Begin implementations for the SlabArena class.
+  -------------------------------------------
+*/
+
+/**
+* Default constructor, no memory is reserved until the first allocation.
+*/
+inline SlabArena::SlabArena()
+  : objSize_(0), slotCount_(FIRST_SLAB_SLOTS), slabs_(NULL), lastSlab_(NULL),
+    next_(NULL), end_(NULL), free_(NULL), group_(newGroup())
+{
+
+}
+
+/**
+* Destructor, which gives every slab back to the system unless another arena of
+* the group may still have objects in them. Any objects still living in the arena
+* must already have been destroyed by their owner.
+*/
+inline SlabArena::~SlabArena()
+{
+  std::lock_guard<std::mutex> lock(groupLock());
+  handOverSlabs(group());
+  dropGroup(group_);
+}
+
+/**
+* Returns storage for one object of the given size, taken from the free list if
+* possible and otherwise bumped off the current slab.
+*/
+inline void* SlabArena::allocate(std::size_t bytes)
+{
+  setObjSize(bytes);
+
+  //not the node type this arena was sized for
+  if(bytes > objSize_)
+  {
+    throw std::invalid_argument("SlabArena::allocate got an object larger than the arena's slots");
+  }
+
+  //recycle a freed node first, including ones freed in absorbed arenas
+  if(free_ == NULL && !spareFree_.empty())
+  {
+    free_ = spareFree_.back();
+    spareFree_.pop_back();
+  }
+
+  if(free_ != NULL)
+  {
+    FreeSlot* slot = free_;
+    free_ = slot->next;
+    return slot;
+  }
+
+  if(next_ == end_)
+  {
+    addSlab();
+  }
+
+  void* ptr = next_;
+  next_ += objSize_;
+  return ptr;
+}
+
+/**
+* Puts an object's storage back on the free list. The slab itself is only
+* returned to the system by release(). The object may come from another arena
+* of the same group.
+*/
+inline void SlabArena::deallocate(void* ptr, std::size_t bytes)
+{
+  if(ptr == NULL)
+  {
+    return;
+  }
+
+  //allocate() never hands out a larger object
+  setObjSize(bytes);
+  assert(bytes <= objSize_);
+
+  FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+  slot->next = free_;
+  free_ = slot;
+}
+
+/**
+* Returns true if release() really frees memory, in which case the owner
+* does not need to deallocate its objects one by one first. That is only
+* safe while the arena is alone in its group.
+*/
+inline bool SlabArena::canRelease() const
+{
+  std::lock_guard<std::mutex> lock(groupLock());
+  return group()->refs == 1;
+}
+
+/**
+* Frees every slab at once, or, if canRelease() is false, leaves the slabs to the
+* group and starts a new group of its own. All objects handed out by the arena
+* become invalid, so this must only be called once the owner is done with all of
+* its nodes.
+*/
+inline void SlabArena::release()
+{
+  std::lock_guard<std::mutex> lock(groupLock());
+  Group* group = this->group();
+  if(group->refs == 1)
+  {
+    freeSlabs(slabs_);
+    freeSlabs(group->slabs);
+    group->slabs = NULL;
+    group->lastSlab = NULL;
+    resetSlabs();
+    return;
+  }
+
+  handOverSlabs(group);
+  dropGroup(group);
+  group_ = newGroup();
+}
+
+/**
+* Puts this arena into the group of other, so objects can move freely between
+* the two. This arena must not hold any objects, but its slabs stay with its old
+* group since they may hold objects of that group's other arenas.
+*/
+inline void SlabArena::share(SlabArena& other)
+{
+  std::lock_guard<std::mutex> lock(groupLock());
+  Group* target = other.group();
+  Group* group = this->group();
+  if(group == target)
+  {
+    return;
+  }
+
+  handOverSlabs(group);
+  dropGroup(group);
+  group_ = target;
+  ++target->refs;
+
+  if(objSize_ == 0)
+  {
+    objSize_ = other.objSize_;
+  }
+}
+
+/**
+* Merges the group of other into this arena's group and takes over the slabs and
+* free list of other, for when objects allocated by other are handed to this
+* arena's owner. Both arenas stay in the merged group, other starts over with new
+* slabs. This is O(1); the unused end of other's current slab is only kept if this
+* arena has no room left on its own.
+*/
+inline void SlabArena::absorb(SlabArena& other)
+{
+  if(&other == this)
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(groupLock());
+  Group* group = this->group();
+  Group* gone = other.group();
+  if(group != gone)
+  {
+    spliceSlabs(group->slabs, group->lastSlab, gone->slabs, gone->lastSlab);
+    gone->slabs = NULL;
+    gone->lastSlab = NULL;
+    gone->forward = group;
+    ++group->refs;
+    other.group();
+  }
+
+  //the absorbed objects will be freed here, so the slot size has to match
+  if(objSize_ == 0)
+  {
+    objSize_ = other.objSize_;
+  }
+
+  spliceSlabs(slabs_, lastSlab_, other.slabs_, other.lastSlab_);
+  if(other.free_ != NULL)
+  {
+    spareFree_.push_back(other.free_);
+  }
+  spareFree_.insert(spareFree_.end(), other.spareFree_.begin(), other.spareFree_.end());
+
+  if(next_ == end_)
+  {
+    next_ = other.next_;
+    end_ = other.end_;
+  }
+  if(slotCount_ < other.slotCount_)
+  {
+    slotCount_ = other.slotCount_;
+  }
+
+  other.resetSlabs();
+}
+
+//my helper function, the first object fixes the slot size
+inline void SlabArena::setObjSize(std::size_t bytes)
+{
+  if(objSize_ == 0)
+  {
+    //round up so every slot stays aligned and can hold a free list link
+    const std::size_t align = alignof(std::max_align_t);
+    objSize_ = (bytes < sizeof(FreeSlot) ? sizeof(FreeSlot) : bytes);
+    objSize_ = (objSize_ + align - 1) / align * align;
+  }
+}
+
+//my helper function
+inline void SlabArena::addSlab()
+{
+  Slab* slab = static_cast<Slab*>(::operator new(headerSize() + slotCount_ * objSize_));
+  slab->next = slabs_;
+  if(slabs_ == NULL)
+  {
+    lastSlab_ = slab;
+  }
+  slabs_ = slab;
+
+  next_ = reinterpret_cast<char*>(slab) + headerSize();
+  end_ = next_ + slotCount_ * objSize_;
+
+  //grow geometrically so big trees need few slabs
+  if(slotCount_ < MAX_SLAB_SLOTS)
+  {
+    slotCount_ *= 2;
+  }
+}
+
+//my helper function, leaves this arena's slabs to group and starts over empty
+inline void SlabArena::handOverSlabs(Group* group)
+{
+  spliceSlabs(group->slabs, group->lastSlab, slabs_, lastSlab_);
+  resetSlabs();
+}
+
+//my helper function, forgets the slabs without freeing them
+inline void SlabArena::resetSlabs()
+{
+  slabs_ = NULL;
+  lastSlab_ = NULL;
+  slotCount_ = FIRST_SLAB_SLOTS;
+  next_ = NULL;
+  end_ = NULL;
+  free_ = NULL;
+  spareFree_.clear();
+}
+
+/**
+* Returns the group this arena really belongs to. If its group was absorbed, the
+* arena moves over to the group at the end of the forwards. Needs groupLock().
+*/
+inline SlabArena::Group* SlabArena::group() const
+{
+  if(group_->forward == NULL)
+  {
+    return group_;
+  }
+
+  Group* target = group_->forward;
+  while(target->forward != NULL)
+  {
+    target = target->forward;
+  }
+
+  ++target->refs;
+  dropGroup(group_);
+  group_ = target;
+  return target;
+}
+
+//my helper function
+inline SlabArena::Group* SlabArena::newGroup()
+{
+  Group* group = new Group;
+  group->refs = 1;
+  group->slabs = NULL;
+  group->lastSlab = NULL;
+  group->forward = NULL;
+  return group;
+}
+
+//my helper function, frees the group and its slabs once nothing uses it anymore
+inline void SlabArena::dropGroup(Group* group)
+{
+  while(group != NULL && --group->refs == 0)
+  {
+    Group* forward = group->forward;
+    freeSlabs(group->slabs);
+    delete group;
+
+    //a forwarding group held a reference to its target
+    group = forward;
+  }
+}
+
+//my helper function, puts the list first..last in front of slabs
+inline void SlabArena::spliceSlabs(Slab*& slabs, Slab*& lastSlab, Slab* first, Slab* last)
+{
+  if(first == NULL)
+  {
+    return;
+  }
+
+  last->next = slabs;
+  if(slabs == NULL)
+  {
+    lastSlab = last;
+  }
+  slabs = first;
+}
+
+//my helper function
+inline void SlabArena::freeSlabs(Slab* slabs)
+{
+  while(slabs != NULL)
+  {
+    Slab* temp = slabs;
+    slabs = slabs->next;
+    ::operator delete(temp);
+  }
+}
+
+//my helper function, one lock for the groups of all arenas
+inline std::mutex& SlabArena::groupLock()
+{
+  static std::mutex lock;
+  return lock;
+}
+
+//my helper function
+inline std::size_t SlabArena::headerSize()
+{
+  //keep the first slot as aligned as operator new would make it
+  const std::size_t align = alignof(std::max_align_t);
+  return (sizeof(Slab) + align - 1) / align * align;
+}
+
+/*
+  -----------------------------------------
+  End implementations for the SlabArena class.
+  -----------------------------------------
+*/
+
+/*
+  -----------------------------------------------
+  Begin implementations for the HeapAllocator class.
+  -----------------------------------------------
+*/
+
+/**
+* Allocates one object with operator new.
+*/
+inline void* HeapAllocator::allocate(std::size_t bytes)
+{
+  return ::operator new(bytes);
+}
+
+/**
+* Frees one object with operator delete.
+*/
+inline void HeapAllocator::deallocate(void* ptr, std::size_t bytes)
+{
+  ::operator delete(ptr);
+}
+
+/**
+* Memory from the heap cannot be released in bulk, so every node
+* has to be deallocated on its own.
+*/
+inline bool HeapAllocator::canRelease() const
+{
+  return false;
+}
+
+/**
+* Nothing to do, see canRelease().
+*/
+inline void HeapAllocator::release()
+{
+
+}
+
+/**
+* Every HeapAllocator uses the same heap, so objects can always move between them.
+*/
+inline void HeapAllocator::share(HeapAllocator& other)
+{
+
+}
+
+/**
+* See share().
+*/
+inline void HeapAllocator::absorb(HeapAllocator& other)
+{
+
+}
+
+/*
+  ---------------------------------------------
+  End implementations for the HeapAllocator class.
+  ---------------------------------------------
+*/
+
+#endif
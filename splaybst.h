@@ -0,0 +1,342 @@
+#ifndef SPLAYBST_H
+#define SPLAYBST_H
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include "bst.h"
+
+/**
+* A self adjusting splay tree. Every access rotates the node it reached up to the
+* root, halving the depth of the nodes on the way, so keys that are used often stay
+* near the top and a lookup of a hot key costs O(log(1/p)) for a key hit with
+* probability p, instead of the O(log n) of a balanced tree. Any sequence of
+* operations costs amortized O(log n) each, but a single one can take O(n), e.g.
+* the first lookup after inserting keys in order.
+* A splay node needs no extra data, so the tree uses the plain Node.
+* Lookups through a non-const tree (find, operator[] and the inserts) splay; the
+* const overloads, iteration and the bounds leave the shape alone.
+*/
+template <class Key, class Value, class Alloc = SlabArena>
+class SplayTree : public BinarySearchTree<Key, Value, Alloc>
+{
+  public:
+    typedef typename BinarySearchTree<Key, Value, Alloc>::iterator iterator;
+
+    SplayTree();
+    using BinarySearchTree<Key, Value, Alloc>::insert;
+    virtual void insert(const std::pair<const Key, Value>& new_item) override;
+    virtual void remove(const Key& key);
+    using BinarySearchTree<Key, Value, Alloc>::find;
+    iterator find(const Key& key);
+    using BinarySearchTree<Key, Value, Alloc>::operator[];
+    Value& operator[](const Key& key);
+
+    // Move aware insertion, see BinarySearchTree
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value);
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(Key&& key, V&& value);
+    virtual iterator insert(iterator hint, const std::pair<const Key, Value>& new_item) override;
+
+  protected:
+    typedef Node<Key, Value> NodeType;
+
+    virtual std::pair<iterator, bool> moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite) override;
+    virtual bool plainNodes() const override;
+
+    // Add helper functions here
+    NodeType* splayFind(const Key& key);
+    void splay(NodeType* node, NodeType* top = NULL);
+    void rotateUp(NodeType* node);
+};
+
+//constructor
+template<class Key, class Value, class Alloc>
+SplayTree<Key, Value, Alloc>::SplayTree() : BinarySearchTree<Key, Value, Alloc>() {}
+
+template<class Key, class Value, class Alloc>
+void SplayTree<Key, Value, Alloc>::insert(const std::pair<const Key, Value>& new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  insert_or_assign(std::move(item.first), std::move(item.second));
+}
+
+/**
+* Returns an iterator to the item with the given key, or end() if there is none.
+* The item is splayed to the root, or the last node on the search path if the
+* key is missing.
+*/
+template<class Key, class Value, class Alloc>
+typename SplayTree<Key, Value, Alloc>::iterator SplayTree<Key, Value, Alloc>::find(const Key& key)
+{
+  return this->makeIterator(splayFind(key));
+}
+
+/**
+* Like find, but returns the value and throws std::out_of_range if there is none.
+*/
+template<class Key, class Value, class Alloc>
+Value& SplayTree<Key, Value, Alloc>::operator[](const Key& key)
+{
+  NodeType* curr = splayFind(key);
+  if(curr == NULL) throw std::out_of_range("Invalid key");
+  return curr->getValue();
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::emplace(Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceItemNode<NodeType>(std::forward<Args>(args)...);
+  splay(result.first);
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::try_emplace(const Key& key, Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(key, std::forward<Args>(args)...);
+  splay(result.first);
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename... Args>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::try_emplace(Key&& key, Args&&... args)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(std::move(key), std::forward<Args>(args)...);
+  splay(result.first);
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::insert_or_assign(const Key& key, V&& value)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(key, std::forward<V>(value));
+  if(!result.second)
+  {
+    result.first->getValue() = std::forward<V>(value);
+  }
+  splay(result.first);
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+template<class Key, class Value, class Alloc>
+template<typename V>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::insert_or_assign(Key&& key, V&& value)
+{
+  std::pair<NodeType*, bool> result = this->template emplaceNode<NodeType>(std::move(key), std::forward<V>(value));
+  if(!result.second)
+  {
+    result.first->getValue() = std::forward<V>(value);
+  }
+  splay(result.first);
+  return std::make_pair(this->makeIterator(result.first), result.second);
+}
+
+/**
+* Hinted insert, see BinarySearchTree. The item is splayed like any other insert,
+* so for keys fed in ascending order the hint is always the root and each insert
+* takes O(1).
+*/
+template<class Key, class Value, class Alloc>
+typename SplayTree<Key, Value, Alloc>::iterator
+SplayTree<Key, Value, Alloc>::insert(iterator hint, const std::pair<const Key, Value>& new_item)
+{
+  std::pair<Key, Value> item = this->copyItem(new_item);
+  std::pair<NodeType*, bool> result =
+    this->template emplaceNodeHint<NodeType>(this->hintNode(hint), std::move(item.first), std::move(item.second));
+  if(!result.second)
+  {
+    result.first->setValue(std::move(item.second));
+  }
+  splay(result.first);
+  return this->makeIterator(result.first);
+}
+
+template<class Key, class Value, class Alloc>
+std::pair<typename SplayTree<Key, Value, Alloc>::iterator, bool>
+SplayTree<Key, Value, Alloc>::moveInsert(std::pair<Key, Value>& keyValuePair, bool overwrite)
+{
+  if(overwrite)
+  {
+    return insert_or_assign(std::move(keyValuePair.first), std::move(keyValuePair.second));
+  }
+  return try_emplace(std::move(keyValuePair.first), std::move(keyValuePair.second));
+}
+
+template<class Key, class Value, class Alloc>
+bool SplayTree<Key, Value, Alloc>::plainNodes() const
+{
+  return false;
+}
+
+/**
+* Removes the item with the given key. The node is splayed to the root first, then
+* its predecessor is splayed to the top of the left subtree, where it has no right
+* child and can take over the right subtree in place of the root.
+*/
+template<class Key, class Value, class Alloc>
+void SplayTree<Key, Value, Alloc>::remove(const Key& key)
+{
+  //target node, now at the root
+  NodeType* curr = splayFind(key);
+
+  //target not in tree
+  if(curr == NULL)
+  {
+    return;
+  }
+
+  //the largest node is found again lazily
+  if(curr == this->rightmost_)
+  {
+    this->rightmost_ = NULL;
+  }
+
+  NodeType* left = curr->getLeft();
+  NodeType* right = curr->getRight();
+  NodeType* newRoot = right;
+  if(left != NULL)
+  {
+    splay(this->predecessor(curr), curr);
+    newRoot = curr->getLeft();
+    newRoot->setRight(right);
+    if(right != NULL)
+    {
+      right->setParent(newRoot);
+    }
+  }
+
+  if(newRoot != NULL)
+  {
+    newRoot->setParent(NULL);
+  }
+  this->root_ = newRoot;
+  this->destroyNode(curr);
+}
+
+//my helper function, finds key and splays it or the last node on the way
+template<class Key, class Value, class Alloc>
+Node<Key, Value>* SplayTree<Key, Value, Alloc>::splayFind(const Key& key)
+{
+  NodeType* temp = this->root_;
+  NodeType* last = NULL;
+
+  while(temp != NULL)
+  {
+    last = temp;
+
+    //equal to
+    if(key == temp->getKey())
+    {
+      splay(temp);
+      return temp;
+    }
+
+    temp = (key < temp->getKey()) ? temp->getLeft() : temp->getRight();
+  }
+
+  //a miss pays for its walk as well
+  if(last != NULL)
+  {
+    splay(last);
+  }
+  return NULL;
+}
+
+/**
+* Rotates node up until its parent is top, which makes it the root if top is NULL.
+* Steps go two levels at a time: if node and its parent lean the same way (zig-zig)
+* the parent is rotated first, otherwise (zig-zag) node is rotated up twice. That
+* order is what halves the depth of the path, a plain rotate to the top does not.
+*/
+template<class Key, class Value, class Alloc>
+void SplayTree<Key, Value, Alloc>::splay(NodeType* node, NodeType* top)
+{
+  while(node->getParent() != top)
+  {
+    NodeType* parent = node->getParent();
+    NodeType* grandParent = parent->getParent();
+
+    //zig, one step below top
+    if(grandParent == top)
+    {
+      rotateUp(node);
+    }
+
+    //zig-zig
+    else if((grandParent->getLeft() == parent) == (parent->getLeft() == node))
+    {
+      rotateUp(parent);
+      rotateUp(node);
+    }
+
+    //zig-zag
+    else
+    {
+      rotateUp(node);
+      rotateUp(node);
+    }
+  }
+}
+
+//my helper function, rotates node above its parent
+template<class Key, class Value, class Alloc>
+void SplayTree<Key, Value, Alloc>::rotateUp(NodeType* node)
+{
+  NodeType* parent = node->getParent();
+  NodeType* grandParent = parent->getParent();
+
+  //node takes parent's place under grandParent
+  node->setParent(grandParent);
+  if(grandParent == NULL)
+  {
+    this->root_ = node;
+  }
+  else if(grandParent->getLeft() == parent)
+  {
+    grandParent->setLeft(node);
+  }
+  else
+  {
+    grandParent->setRight(node);
+  }
+
+  //node's inner child moves over to parent
+  if(parent->getLeft() == node)
+  {
+    parent->setLeft(node->getRight());
+    if(node->getRight() != NULL)
+    {
+      node->getRight()->setParent(parent);
+    }
+    node->setRight(parent);
+  }
+  else
+  {
+    parent->setRight(node->getLeft());
+    if(node->getLeft() != NULL)
+    {
+      node->getLeft()->setParent(parent);
+    }
+    node->setLeft(parent);
+  }
+  parent->setParent(node);
+}
+
+#endif